@@ -0,0 +1,154 @@
+// CFS (completely fair) scheduling class.
+//
+// Each process accrues virtual runtime while it runs, at a rate
+// inversely proportional to its weight (its ticket count), and
+// the process with the least virtual runtime runs next.  The
+// run queue is a red-black tree ordered by virtual runtime, so
+// the next process is the cached leftmost node and queueing
+// takes O(log n).
+//
+// Virtual runtimes are only comparable within a run queue:
+// each is kept close to its queue's min_vruntime, which follows
+// the smallest virtual runtime queued.  A process that slept is
+// placed at most one time slice's worth of virtual runtime
+// before min_vruntime, so waking up earns it a bounded lead
+// rather than the whole time it slept.  Comparisons go through
+// the signed difference, so the counters can wrap; that makes a
+// process that fell more than 2^31 behind (at weight 1, about
+// 2048 ticks of running on its queue) look far ahead, so a
+// process is also placed at most one slice's worth after
+// min_vruntime, as stride scheduling does with passes.
+
+#include "types.h"
+#include "defs.h"
+#include "param.h"
+#include "memlayout.h"
+#include "mmu.h"
+#include "proc.h"
+#include "sched.h"
+
+#if SCHED_HAS(CFS)
+
+#define CFS_SCALE (1 << 20)  // Virtual runtime per tick at weight 1
+
+#define rb_proc(n) ((struct proc*)((char*)(n) - (uint)&((struct proc*)0)->rb))
+
+static uint
+weight(struct proc *p)
+{
+  return p->ticket ? p->ticket : 1;
+}
+
+// Virtual runtime p accrues in one tick.
+static uint
+vdelta(struct proc *p)
+{
+  return CFS_SCALE / weight(p);
+}
+
+static int
+vbefore(uint a, uint b)
+{
+  return (int)(a - b) < 0;
+}
+
+// Bring p's virtual runtime in line with rq before queueing it.
+static void
+place(struct runqueue *rq, struct proc *p)
+{
+  struct runqueue *old;
+  uint credit;
+
+  if(p->vcpu < 0)
+    p->vruntime = rq->min_vruntime;
+  else if(&runqueues[p->vcpu] != rq){
+    old = &runqueues[p->vcpu];
+    p->vruntime = p->vruntime - old->min_vruntime + rq->min_vruntime;
+  }
+  p->vcpu = rq - runqueues;
+
+  credit = cfs_class.quantum * vdelta(p);
+  if(vbefore(p->vruntime, rq->min_vruntime - credit))
+    p->vruntime = rq->min_vruntime - credit;
+  else if(vbefore(rq->min_vruntime + credit, p->vruntime))
+    p->vruntime = rq->min_vruntime + credit;
+}
+
+static void
+cfs_enqueue(struct runqueue *rq, struct proc *p)
+{
+  struct rbnode *parent, *n;
+  int dir;
+
+  place(rq, p);
+  parent = 0;
+  dir = 0;
+  for(n = rq->cfs.root; n; n = n->child[dir]){
+    parent = n;
+    // Equal keys go right, so they run in the order queued.
+    dir = !vbefore(p->vruntime, rb_proc(n)->vruntime);
+  }
+  rb_insert(&rq->cfs, parent, dir, &p->rb);
+}
+
+static void
+cfs_dequeue(struct runqueue *rq, struct proc *p)
+{
+  rb_erase(&rq->cfs, &p->rb);
+}
+
+static struct proc*
+cfs_pick_next(struct runqueue *rq, int cpu)
+{
+  struct rbnode *n;
+  struct proc *p;
+
+  if(rq->cfs.leftmost == 0)
+    return NOTHING;
+  p = rb_proc(rq->cfs.leftmost);
+  if(vbefore(rq->min_vruntime, p->vruntime))
+    rq->min_vruntime = p->vruntime;
+  for(n = rq->cfs.leftmost; n; n = rb_next(n))
+    if(can_run(rb_proc(n), cpu))
+      return rb_proc(n);
+  return NOTHING;
+}
+
+// Called without ptable.lock, but only p itself changes its
+// virtual runtime while it runs.
+static int
+cfs_tick(struct proc *p)
+{
+  p->vruntime += vdelta(p);
+  return 0;
+}
+
+// Promote processes that have waited too long.  The tree is
+// ordered by virtual runtime rather than waiting time, so every
+// process has to be checked.
+static void
+cfs_age(struct runqueue *rq)
+{
+  struct rbnode *n, *next;
+  struct proc *p;
+
+  for(n = rq->cfs.leftmost; n; n = next){
+    next = rb_next(n);
+    p = rb_proc(n);
+    if(ticks - p->runnable_since > AGING_CYCLE)
+      promote(p);
+  }
+}
+
+struct schedclass cfs_class = {
+  .name = "cfs",
+  .queue = CFS,
+  .quantum = TIME_QUANTUM,
+  .enqueue = cfs_enqueue,
+  .dequeue = cfs_dequeue,
+  .pick_next = cfs_pick_next,
+  .tick = cfs_tick,
+  .age = cfs_age,
+};
+
+#endif
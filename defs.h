@@ -1,25 +1,32 @@
 struct buf;
 struct context;
+struct cpustat;
 struct file;
 struct inode;
 struct pipe;
 struct proc;
+struct proclist;
+struct rbnode;
+struct rbtree;
 struct rtcdate;
+struct runqueue;
+struct schedclass;
+struct sched_param;
 struct spinlock;
 struct sleeplock;
 struct stat;
 struct superblock;
+struct timer;
 
 typedef int Bool;
 
 #define TRUE 1
 #define FALSE 0
-#define LOTTERY 1
-#define ROUND_ROBIN 2
-#define HRRN 3
 #define NOTHING 0
 #define HRRN_PRECISION 4
 #define CYCLES_PRECISION 1
+#define HRRN_SCALE 10000  // 10^HRRN_PRECISION
+#define CYCLES_SCALE 10   // 10^CYCLES_PRECISION
 
 // bio.c
 void            binit(void);
@@ -27,12 +34,20 @@ struct buf*     bread(uint, uint);
 void            brelse(struct buf*);
 void            bwrite(struct buf*);
 
+// cfs.c
+extern struct schedclass cfs_class;
+
 // console.c
 void            consoleinit(void);
 void            cprintf(char*, ...);
 void            consoleintr(int(*)(void));
 void            panic(char*) __attribute__((noreturn));
 
+// edf.c
+extern struct schedclass edf_class;
+int             edf_admit(struct proc*, int, int, int);
+int             edf_preempt(struct proc*);
+
 // exec.c
 int             exec(char*, char**);
 
@@ -90,6 +105,7 @@ extern volatile uint*    lapic;
 void            lapiceoi(void);
 void            lapicinit(void);
 void            lapicstartap(uchar, uint);
+void            lapicipi(int, int);
 void            microdelay(int);
 
 // log.c
@@ -98,6 +114,10 @@ void            log_write(struct buf*);
 void            begin_op();
 void            end_op();
 
+// mlfq.c
+extern struct schedclass mlfq_class;
+int             set_mlfq_boost(int);
+
 // mp.c
 extern int      ismp;
 void            mpinit(void);
@@ -119,6 +139,7 @@ void            exit(void);
 int             fork(void);
 int             growproc(int);
 int             kill(int);
+struct cpu*     lapiccpu(void);
 struct cpu*     mycpu(void);
 struct proc*    myproc();
 void            pinit(void);
@@ -130,11 +151,67 @@ void            sleep(void*, struct spinlock*);
 void            userinit(void);
 int             wait(void);
 void            wakeup(void*);
+void            wakeup_one(void*);
 void            yield(void);
 int 			set_proc_queue(int, int);
 int 			set_proc_ticket(int, int);
+int             set_queue_mode(int, int);
+int             set_proc_rt(int, int, int, int);
+int             set_affinity(int, uint);
+int             get_affinity(int);
+int             get_migrations(int);
+int             sched_setparams(struct sched_param*, int);
+void            balancetick(void);
 int 			print_processes(void);
 
+// rand.c
+uint            rand(void);
+void            srand(uint);
+
+// hrrn.c
+extern struct schedclass hrrn_class;
+uint            hrrn_ratio(struct proc*);
+
+// lottery.c
+extern struct schedclass lottery_class;
+
+// rbtree.c
+void            rb_erase(struct rbtree*, struct rbnode*);
+void            rb_insert(struct rbtree*, struct rbnode*, int, struct rbnode*);
+struct rbnode*  rb_next(struct rbnode*);
+
+// roundrobin.c
+extern struct schedclass rr_class;
+
+// sched.c
+int             can_run(struct proc*, int);
+void            change_queue(struct proc*, int);
+void            dequeue_proc(struct proc*);
+void            requeue_proc(struct proc*);
+void            enqueue_proc(struct proc*);
+int             getschedstat(struct cpustat*, int);
+void            promote(struct proc*);
+void            proclist_append(struct proclist*, struct proc*);
+struct proc*    proclist_first(struct proclist*, int);
+void            proclist_insert(struct proclist*, struct proc*, struct proc*);
+void            proclist_remove(struct proclist*, struct proc*);
+struct schedclass* sched_class(int);
+void            sched_exit(struct proc*);
+int             sched_setmode(int, int);
+void            sched_yield(struct proc*);
+void            schedinit(void);
+int             set_cpu_mask(struct proc*, uint);
+int             set_queue_quantum(int, int);
+int             slice_tick(struct proc*);
+void            start_slice(struct proc*);
+int             have_runnable(int);
+void            count_canrun(struct runqueue*, struct proc*, int);
+void            idle(struct cpu*);
+void            kick(struct proc*);
+struct proc*    pick_next_proc(struct cpu*);
+int             balance_due(int);
+void            balance(int);
+
 // swtch.S
 void            swtch(struct context**, struct context*);
 
@@ -171,7 +248,9 @@ int             fetchstr(uint, char**);
 void            syscall(void);
 
 // timer.c
-void            timerinit(void);
+void            timer_add(struct timer*, uint);
+void            timer_del(struct timer*);
+void            timer_tick(void);
 
 // trap.c
 void            idtinit(void);
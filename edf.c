@@ -0,0 +1,204 @@
+// EDF (earliest deadline first) real-time scheduling class.
+//
+// set_proc_rt() gives a process a period, a runtime budget and
+// a relative deadline, all in ticks, and moves it here, ahead
+// of every other queue.  In each period the process may run for
+// its budget; the runnable process with the earliest absolute
+// deadline runs first.  A process that uses up its budget is
+// taken off the CPU from the timer interrupt and throttled until
+// its next period starts.  A process that wakes up after its
+// deadline has passed starts a new period at once.
+//
+// Admission keeps the total utilization, the sum of
+// runtime/period over all EDF processes, at or below one CPU's
+// worth, so every admitted process can meet its deadlines.
+// For that, a ready EDF process preempts a process of any other
+// class, or one with a later deadline, at the next tick rather
+// than waiting for its slice to run out.
+//
+// Ready processes are kept in a list sorted by deadline and
+// throttled ones in an unsorted list; real-time processes are
+// expected to be few.
+
+#include "types.h"
+#include "defs.h"
+#include "param.h"
+#include "memlayout.h"
+#include "mmu.h"
+#include "proc.h"
+#include "sched.h"
+
+#if SCHED_HAS(EDF)
+
+#define UTIL_SCALE (1 << 16)  // Utilization of a whole CPU
+#define MAXPERIOD 0xffff      // So runtime*UTIL_SCALE fits in a uint
+
+static uint utilization;      // Admitted, in 1/UTIL_SCALE
+
+static int
+tbefore(uint a, uint b)
+{
+  return (int)(a - b) < 0;
+}
+
+// Insert p into the ready list behind every process with an
+// earlier or equal deadline.
+static void
+ready(struct runqueue *rq, struct proc *p)
+{
+  struct proc *q;
+
+  for(q = rq->edf.tail; q && tbefore(p->rt_deadline, q->rt_deadline); q = q->rq_prev)
+    ;
+  proclist_insert(&rq->edf, q, p);
+}
+
+// Start p's period at release.
+static void
+replenish(struct proc *p, uint release)
+{
+  p->rt_release = release;
+  p->rt_deadline = release + p->rt_reldeadline;
+  p->rt_budget = p->rt_runtime;
+}
+
+static void
+edf_enqueue(struct runqueue *rq, struct proc *p)
+{
+  if(p->rt_budget <= 0 && tbefore(ticks, p->rt_release + p->rt_period)){
+    if(rq->edf_throttled.head == 0 ||
+       tbefore(p->rt_release + p->rt_period, rq->edf_release))
+      rq->edf_release = p->rt_release + p->rt_period;
+    p->rt_throttled = 1;
+    proclist_append(&rq->edf_throttled, p);
+    return;
+  }
+  if(p->rt_budget <= 0 || !tbefore(ticks, p->rt_deadline))
+    replenish(p, ticks);
+  ready(rq, p);
+}
+
+static void
+edf_dequeue(struct runqueue *rq, struct proc *p)
+{
+  if(p->rt_throttled){
+    p->rt_throttled = 0;
+    proclist_remove(&rq->edf_throttled, p);
+  } else
+    proclist_remove(&rq->edf, p);
+}
+
+// Release the throttled processes whose next period has begun,
+// counting them back into the idle hint (see have_runnable).
+static struct proc*
+edf_pick_next(struct runqueue *rq, int cpu)
+{
+  struct proc *p, *next;
+  uint release;
+
+  for(p = rq->edf_throttled.head; p; p = next){
+    next = p->rq_next;
+    release = p->rt_release + p->rt_period;
+    if(!tbefore(ticks, release)){
+      proclist_remove(&rq->edf_throttled, p);
+      p->rt_throttled = 0;
+      count_canrun(rq, p, 1);
+      replenish(p, release);
+      ready(rq, p);
+    } else if(p == rq->edf_throttled.head || tbefore(release, rq->edf_release))
+      rq->edf_release = release;
+  }
+  return proclist_first(&rq->edf, cpu);
+}
+
+// Charge p a tick of its budget.  Called from the timer
+// interrupt; only p changes its budget while it runs.
+static int
+edf_tick(struct proc *p)
+{
+  return --p->rt_budget <= 0;
+}
+
+static void
+edf_leave(struct proc *p)
+{
+  utilization -= p->rt_util;
+  p->rt_util = 0;
+}
+
+// Should the running process p make way for an EDF process
+// on its CPU: one that is ready and p isn't EDF or has a later
+// deadline, or a throttled one that is due for release?  Called
+// from the timer interrupt without ptable.lock; processes are
+// never freed, so a stale look only delays or wastes one
+// preemption.
+int
+edf_preempt(struct proc *p)
+{
+  struct runqueue *rq = &runqueues[p->cpu];
+  struct proc *q;
+
+  if(rq->edf_throttled.head && !tbefore(ticks, rq->edf_release))
+    return 1;
+  if((q = rq->edf.head) == 0)
+    return 0;
+  return p->queue_num != EDF || tbefore(q->rt_deadline, p->rt_deadline);
+}
+
+struct schedclass edf_class = {
+  .name = "edf",
+  .queue = EDF,
+  .quantum = TIME_QUANTUM,
+  .enqueue = edf_enqueue,
+  .dequeue = edf_dequeue,
+  .pick_next = edf_pick_next,
+  .tick = edf_tick,
+  .leave = edf_leave,
+};
+
+// Give p the real-time parameters period, runtime and deadline
+// and move it to the EDF queue, if the total utilization stays
+// at or below 100%.  The ptable lock must be held.
+int
+edf_admit(struct proc *p, int period, int runtime, int deadline)
+{
+  uint util, old;
+
+  // A zombie has been through sched_exit() already, and nothing
+  // would give its bandwidth back.
+  if(p->state == ZOMBIE || p->state == UNUSED)
+    return -1;
+  if(runtime < 1 || deadline < runtime || period < deadline || period > MAXPERIOD)
+    return -1;
+  util = ((uint)runtime * UTIL_SCALE + period - 1) / period;
+  old = p->queue_num == EDF ? p->rt_util : 0;
+  if(utilization - old + util > UTIL_SCALE)
+    return -1;
+  utilization += util - old;
+
+  // Only enqueue looks at the parameters, so they can be
+  // changed before change_queue() requeues p.
+  p->rt_util = util;
+  p->rt_period = period;
+  p->rt_runtime = runtime;
+  p->rt_reldeadline = deadline;
+  replenish(p, ticks);
+  change_queue(p, EDF);
+  return 0;
+}
+
+#else
+
+int
+edf_admit(struct proc *p, int period, int runtime, int deadline)
+{
+  return -1;
+}
+
+int
+edf_preempt(struct proc *p)
+{
+  return 0;
+}
+
+#endif
@@ -6,6 +6,7 @@
 #include "defs.h"
 #include "x86.h"
 #include "elf.h"
+#include "sched.h"
 
 int
 exec(char *path, char **argv)
@@ -99,8 +100,11 @@ exec(char *path, char **argv)
   curproc->sz = sz;
   curproc->tf->eip = elf.entry;  // main
   curproc->tf->esp = sp;
-  curproc->ticket = 50;
-  curproc->queue_num = LOTTERY;
+  if(curproc->queue_num != EDF && curproc->queue_num != MLFQ){
+    // Real-time parameters and MLFQ survive exec.
+    curproc->ticket = 50;
+    curproc->queue_num = EXEC_QUEUE;
+  }
   switchuvm(curproc);
   freevm(oldpgdir);
   return 0;
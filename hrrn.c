@@ -0,0 +1,104 @@
+// HRRN (highest response ratio next) scheduling class.
+//
+// The list is kept sorted by response ratio, highest first.
+// Ratios are integers in 1/HRRN_SCALE units and only change as
+// ticks advance, so they are recomputed at most once per tick,
+// by the first pick that notices the tick has moved on.
+
+#include "types.h"
+#include "defs.h"
+#include "param.h"
+#include "memlayout.h"
+#include "mmu.h"
+#include "proc.h"
+#include "sched.h"
+
+// Response ratio of p, waiting time over whole cycles,
+// in 1/HRRN_SCALE units.  Saturates instead of overflowing.
+uint
+hrrn_ratio(struct proc *p)
+{
+  uint waiting, cycles;
+
+  waiting = ticks - p->arrival_time;
+  cycles = p->cycles / CYCLES_SCALE;
+  if(waiting / cycles >= 0xffffffff / HRRN_SCALE)
+    return 0xffffffff;
+  return waiting / cycles * HRRN_SCALE + waiting % cycles * HRRN_SCALE / cycles;
+}
+
+#if SCHED_HAS(HRRN)
+
+// Insert p into the list behind every process with an equal
+// or higher ratio.  Searches from the tail, which is short
+// work when processes arrive roughly in order.
+static void
+hrrn_insert(struct runqueue *rq, struct proc *p)
+{
+  struct proc *q;
+
+  for(q = rq->hrrn.tail; q && q->hrrn < p->hrrn; q = q->rq_prev)
+    ;
+  proclist_insert(&rq->hrrn, q, p);
+}
+
+// Recompute every ratio in rq's list and re-sort it.
+static void
+hrrn_refresh(struct runqueue *rq)
+{
+  struct proc *p, *next;
+
+  p = rq->hrrn.head;
+  rq->hrrn.head = rq->hrrn.tail = 0;
+  for(; p; p = next){
+    next = p->rq_next;
+    p->hrrn = hrrn_ratio(p);
+    hrrn_insert(rq, p);
+  }
+  rq->hrrn_stamp = ticks;
+}
+
+static void
+hrrn_enqueue(struct runqueue *rq, struct proc *p)
+{
+  p->hrrn = hrrn_ratio(p);
+  hrrn_insert(rq, p);
+}
+
+static void
+hrrn_dequeue(struct runqueue *rq, struct proc *p)
+{
+  proclist_remove(&rq->hrrn, p);
+}
+
+static struct proc*
+hrrn_pick_next(struct runqueue *rq, int cpu)
+{
+  if(rq->hrrn_stamp != ticks)
+    hrrn_refresh(rq);
+  return proclist_first(&rq->hrrn, cpu);
+}
+
+static void
+hrrn_age(struct runqueue *rq)
+{
+  struct proc *p, *next;
+
+  for(p = rq->hrrn.head; p; p = next){
+    next = p->rq_next;
+    if(ticks - p->runnable_since > AGING_CYCLE)
+      promote(p);
+  }
+}
+
+struct schedclass hrrn_class = {
+  .name = "hrrn",
+  .queue = HRRN,
+  .quantum = TIME_QUANTUM,
+  .enqueue = hrrn_enqueue,
+  .dequeue = hrrn_dequeue,
+  .pick_next = hrrn_pick_next,
+  .age = hrrn_age,
+};
+
+#endif
@@ -42,6 +42,7 @@ struct log {
   int size;
   int outstanding; // how many FS sys calls are executing.
   int committing;  // in commit(), please wait.
+  int nwaiting;    // begin_op() callers asleep on &log.
   int dev;
   struct logheader lh;
 };
@@ -121,6 +122,16 @@ recover_from_log(void)
   write_head(); // clear the log
 }
 
+// Sleep in begin_op(), counted in log.nwaiting so that
+// wakers can skip wakeup_one() when nobody waits.
+static void
+logwait(void)
+{
+  log.nwaiting++;
+  sleep(&log, &log.lock);
+  log.nwaiting--;
+}
+
 // called at the start of each FS system call.
 void
 begin_op(void)
@@ -128,12 +139,15 @@ begin_op(void)
   acquire(&log.lock);
   while(1){
     if(log.committing){
-      sleep(&log, &log.lock);
+      logwait();
     } else if(log.lh.n + (log.outstanding+1)*MAXOPBLOCKS > LOGSIZE){
       // this op might exhaust log space; wait for commit.
-      sleep(&log, &log.lock);
+      logwait();
     } else {
       log.outstanding += 1;
+      // There may be room for the next waiter too.
+      if(log.nwaiting)
+        wakeup_one(&log);
       release(&log.lock);
       break;
     }
@@ -157,8 +171,9 @@ end_op(void)
   } else {
     // begin_op() may be waiting for log space,
     // and decrementing log.outstanding has decreased
-    // the amount of reserved space.
-    wakeup(&log);
+    // the amount of reserved space, by one op's worth.
+    if(log.nwaiting)
+      wakeup_one(&log);
   }
   release(&log.lock);
 
@@ -168,7 +183,9 @@ end_op(void)
     commit();
     acquire(&log.lock);
     log.committing = 0;
-    wakeup(&log);
+    // Each waiter that gets in wakes the next (see begin_op).
+    if(log.nwaiting)
+      wakeup_one(&log);
     release(&log.lock);
   }
 }
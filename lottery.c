@@ -0,0 +1,283 @@
+// LOTTERY scheduling class.
+//
+// Ticket counts are kept in a Fenwick tree indexed by process
+// table slot, so the total is known up front and a draw takes
+// O(log NPROC).
+//
+// In MODE_STRIDE the same tickets drive a stride scheduler
+// instead: each process advances a pass value by its stride,
+// STRIDE1 / tickets, for every tick it runs, and the process
+// with the lowest pass runs next, from a min-heap.  Shares are
+// then exact over a few rounds rather than on average.  A
+// process is queued no further behind the run queue's pass than
+// the last process picked, and no further ahead than one time
+// slice, so sleeping or moving to another CPU neither banks nor
+// loses much.
+
+#include "types.h"
+#include "defs.h"
+#include "param.h"
+#include "memlayout.h"
+#include "mmu.h"
+#include "proc.h"
+#include "sched.h"
+
+#if SCHED_HAS(LOTTERY)
+
+#define STRIDE1 (1 << 20)
+
+static int mode = MODE_LOTTERY;
+
+// Add delta tickets to slot i (0-based) of rq's lottery tree.
+static void
+lottery_update(struct runqueue *rq, int i, uint delta)
+{
+  for(i++; i <= NPROC; i += i & -i)
+    rq->lottery_tree[i] += delta;
+}
+
+static int
+passbefore(uint a, uint b)
+{
+  return (int)(a - b) < 0;
+}
+
+static void
+heap_set(struct runqueue *rq, int i, struct proc *p)
+{
+  rq->stride_heap[i] = p;
+  p->heapidx = i;
+}
+
+static void
+heap_up(struct runqueue *rq, int i)
+{
+  struct proc *p = rq->stride_heap[i];
+
+  for(; i > 0 && passbefore(p->pass, rq->stride_heap[(i-1)/2]->pass); i = (i-1)/2)
+    heap_set(rq, i, rq->stride_heap[(i-1)/2]);
+  heap_set(rq, i, p);
+}
+
+static void
+heap_down(struct runqueue *rq, int i)
+{
+  struct proc *p = rq->stride_heap[i];
+  int c;
+
+  for(; (c = 2*i+1) < rq->stride_n; i = c){
+    if(c+1 < rq->stride_n &&
+       passbefore(rq->stride_heap[c+1]->pass, rq->stride_heap[c]->pass))
+      c++;
+    if(!passbefore(rq->stride_heap[c]->pass, p->pass))
+      break;
+    heap_set(rq, i, rq->stride_heap[c]);
+  }
+  heap_set(rq, i, p);
+}
+
+static void
+stride_enqueue(struct runqueue *rq, struct proc *p)
+{
+  uint tickets = p->ticket + p->comp_tickets;
+
+  p->stride = STRIDE1 / (tickets ? tickets : 1);
+  if(passbefore(p->pass, rq->stride_pass))
+    p->pass = rq->stride_pass;
+  else if(passbefore(rq->stride_pass + lottery_class.quantum * p->stride, p->pass))
+    p->pass = rq->stride_pass + lottery_class.quantum * p->stride;
+  heap_set(rq, rq->stride_n++, p);
+  heap_up(rq, p->heapidx);
+}
+
+static void
+stride_dequeue(struct runqueue *rq, struct proc *p)
+{
+  int i = p->heapidx;
+
+  if(--rq->stride_n == i)
+    return;
+  heap_set(rq, i, rq->stride_heap[rq->stride_n]);
+  heap_up(rq, i);
+  heap_down(rq, rq->stride_heap[i]->heapidx);
+}
+
+static void
+lottery_enqueue(struct runqueue *rq, struct proc *p)
+{
+  uint tickets = p->ticket + p->comp_tickets;
+
+  if(mode == MODE_STRIDE){
+    stride_enqueue(rq, p);
+    return;
+  }
+  rq->lottery_proc[p->slot] = p;
+  rq->lottery_tickets[p->slot] = tickets;
+  rq->total_tickets += tickets;
+  lottery_update(rq, p->slot, tickets);
+}
+
+static void
+lottery_dequeue(struct runqueue *rq, struct proc *p)
+{
+  uint tickets = rq->lottery_tickets[p->slot];
+
+  if(mode == MODE_STRIDE){
+    stride_dequeue(rq, p);
+    return;
+  }
+  rq->lottery_proc[p->slot] = 0;
+  rq->lottery_tickets[p->slot] = 0;
+  rq->total_tickets -= tickets;
+  lottery_update(rq, p->slot, -tickets);
+}
+
+// Return the process holding ticket number goal, that is the
+// first slot whose ticket prefix sum exceeds goal.
+static struct proc*
+lottery_find(struct runqueue *rq, uint goal)
+{
+  int pos, step;
+
+  for(step = 1; step*2 <= NPROC; step *= 2)
+    ;
+  pos = 0;
+  for(; step > 0; step /= 2){
+    if(pos + step <= NPROC && rq->lottery_tree[pos + step] <= goal){
+      pos += step;
+      goal -= rq->lottery_tree[pos];
+    }
+  }
+  return rq->lottery_proc[pos];
+}
+
+// Pick among the processes in rq that may run on cpu, for a
+// CPU stealing work that the usual pick can't run: a draw in
+// MODE_LOTTERY, the lowest pass in MODE_STRIDE.  Scans the
+// whole queue, but only on the stealing path.
+static struct proc*
+lottery_scan(struct runqueue *rq, int cpu)
+{
+  struct proc *p, *best;
+  uint total, goal;
+  int i;
+
+  best = NOTHING;
+  if(mode == MODE_STRIDE){
+    for(i = 0; i < rq->stride_n; i++){
+      p = rq->stride_heap[i];
+      if(can_run(p, cpu) && (best == NOTHING || passbefore(p->pass, best->pass)))
+        best = p;
+    }
+    return best;
+  }
+  total = 0;
+  for(i = 0; i < NPROC; i++)
+    if((p = rq->lottery_proc[i]) && can_run(p, cpu)){
+      total += rq->lottery_tickets[i];
+      best = p;
+    }
+  if(total == 0)
+    return best;
+  goal = rand() % total;
+  for(i = 0; i < NPROC; i++){
+    if((p = rq->lottery_proc[i]) && can_run(p, cpu)){
+      if(goal < rq->lottery_tickets[i])
+        return p;
+      goal -= rq->lottery_tickets[i];
+    }
+  }
+  return best;
+}
+
+static struct proc*
+lottery_pick_next(struct runqueue *rq, int cpu)
+{
+  struct proc *p;
+  int i;
+
+  if(mode == MODE_STRIDE){
+    if(rq->stride_n == 0)
+      return NOTHING;
+    p = rq->stride_heap[0];
+    if(!can_run(p, cpu))
+      return lottery_scan(rq, cpu);
+    rq->stride_pass = p->pass;
+    return p;
+  }
+  if(rq->total_tickets == 0){
+    // Only zero-ticket processes: run any of them.
+    for(i = 0; i < NPROC; i++)
+      if(rq->lottery_proc[i] && can_run(rq->lottery_proc[i], cpu))
+        return rq->lottery_proc[i];
+    return NOTHING;
+  }
+  p = lottery_find(rq, rand() % rq->total_tickets);
+  if(!can_run(p, cpu))
+    return lottery_scan(rq, cpu);
+  return p;
+}
+
+// p is blocking before its time slice ran out.  If it used only
+// a fraction f of its quantum it holds 1/f times its tickets
+// until it next runs (Waldspurger's compensation tickets), so
+// giving up the CPU early does not cost it its share.
+static void
+lottery_yield(struct proc *p)
+{
+  int q, used;
+
+  q = lottery_class.quantum;
+  used = q - p->slice + 1;  // count the tick in progress
+  if(used < 1)
+    used = 1;
+  if(used < q)
+    p->comp_tickets = p->ticket * (q - used) / used;
+}
+
+static int
+lottery_tick(struct proc *p)
+{
+  if(mode == MODE_STRIDE)
+    p->pass += p->stride;
+  return 0;
+}
+
+// Switch between MODE_LOTTERY and MODE_STRIDE, moving every
+// queued process over.  The ptable lock must be held.
+static int
+lottery_setmode(int m)
+{
+  struct proc *queued[NPROC];
+  struct runqueue *rq;
+  int i, n, old;
+
+  if(m != MODE_LOTTERY && m != MODE_STRIDE)
+    return -1;
+  old = mode;
+  for(rq = runqueues; rq < &runqueues[ncpu]; rq++){
+    mode = old;
+    n = 0;
+    while((queued[n] = lottery_pick_next(rq, rq - runqueues)) != NOTHING)
+      lottery_dequeue(rq, queued[n++]);
+    mode = m;
+    for(i = 0; i < n; i++)
+      lottery_enqueue(rq, queued[i]);
+  }
+  mode = m;
+  return 0;
+}
+
+struct schedclass lottery_class = {
+  .name = "lottery",
+  .queue = LOTTERY,
+  .quantum = TIME_QUANTUM,
+  .enqueue = lottery_enqueue,
+  .dequeue = lottery_dequeue,
+  .pick_next = lottery_pick_next,
+  .tick = lottery_tick,
+  .yield = lottery_yield,
+  .setmode = lottery_setmode,
+};
+
+#endif
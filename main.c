@@ -27,6 +27,7 @@ main(void)
   consoleinit();   // console hardware
   uartinit();      // serial port
   pinit();         // process table
+  schedinit();     // scheduling classes
   tvinit();        // trap vectors
   binit();         // buffer cache
   fileinit();      // file table
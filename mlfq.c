@@ -0,0 +1,184 @@
+// MLFQ (multi-level feedback queue) scheduling class.
+//
+// Processes start at level 0, the highest.  The time slice
+// doubles at each level down.  A process that runs for its
+// whole slice is demoted a level; one that blocks before its
+// slice ends stays where it is, so interactive processes keep
+// their priority without any tuning.  A process is preempted at
+// the next tick when one at a higher level is waiting, so an
+// interactive process that wakes up doesn't wait out a CPU-bound
+// one's long slice.  A preempted process keeps the rest of its
+// slice for next time rather than starting a fresh one, so it
+// is still demoted after a slice's worth of CPU; slices are
+// only refilled on demotion, boost or sleep.
+//
+// Every boost interval all MLFQ processes go back to level 0,
+// so CPU-bound ones are not starved for good and ones that turn
+// interactive recover.
+//
+// Children of MLFQ processes start in MLFQ, and exec keeps a
+// process in it, so putting a shell in MLFQ covers everything
+// run from it.
+
+#include "types.h"
+#include "defs.h"
+#include "param.h"
+#include "memlayout.h"
+#include "mmu.h"
+#include "proc.h"
+#include "sched.h"
+
+#if SCHED_HAS(MLFQ)
+
+static uint boostinterval = MLFQ_BOOST;
+static uint lastboost;         // ticks at last boost
+static uint generation;        // Number of boosts so far
+
+static int
+level_quantum(int level)
+{
+  return mlfq_class.quantum << level;
+}
+
+// Move every queued MLFQ process back to level 0.  Processes
+// that are not queued notice the new generation when they are.
+static void
+boost(void)
+{
+  struct runqueue *rq;
+  struct proc *p;
+  int i;
+
+  lastboost = ticks;
+  generation++;
+  for(rq = runqueues; rq < &runqueues[ncpu]; rq++){
+    for(i = 1; i < MLFQ_LEVELS; i++){
+      while((p = rq->mlfq[i].head) != 0){
+        proclist_remove(&rq->mlfq[i], p);
+        p->mlfq_level = 0;
+        p->mlfq_left = 0;
+        p->mlfq_gen = generation;
+        proclist_append(&rq->mlfq[0], p);
+      }
+    }
+  }
+}
+
+static void
+mlfq_enqueue(struct runqueue *rq, struct proc *p)
+{
+  if(p->mlfq_gen != generation){
+    p->mlfq_level = 0;
+    p->mlfq_left = 0;
+    p->mlfq_gen = generation;
+  }
+  proclist_append(&rq->mlfq[p->mlfq_level], p);
+}
+
+static void
+mlfq_dequeue(struct runqueue *rq, struct proc *p)
+{
+  proclist_remove(&rq->mlfq[p->mlfq_level], p);
+}
+
+static struct proc*
+mlfq_pick_next(struct runqueue *rq, int cpu)
+{
+  struct proc *p;
+  int i;
+
+  if(ticks - lastboost >= boostinterval)
+    boost();
+  for(i = 0; i < MLFQ_LEVELS; i++)
+    if((p = proclist_first(&rq->mlfq[i], cpu)) != NOTHING)
+      return p;
+  return NOTHING;
+}
+
+static void
+mlfq_dispatch(struct proc *p)
+{
+  if(p->mlfq_left > 0)
+    p->slice = p->mlfq_left;
+  else
+    p->slice = level_quantum(p->mlfq_level);
+}
+
+// Demote p if this tick ends its slice, and preempt it if a
+// process at a higher level is waiting on its CPU.  Called from
+// the timer interrupt, without ptable.lock, before the core
+// charges the tick to p->slice; a stale look at the lists only
+// delays or wastes one preemption.
+static int
+mlfq_tick(struct proc *p)
+{
+  struct runqueue *rq = &runqueues[p->cpu];
+  int i;
+
+  // Whatever takes p off the CPU, it resumes with the rest of
+  // this slice.
+  p->mlfq_left = p->slice - 1;
+  if(p->slice <= 1 && p->mlfq_level < MLFQ_LEVELS-1)
+    p->mlfq_level++;
+  for(i = 0; i < p->mlfq_level; i++)
+    if(rq->mlfq[i].head)
+      return 1;
+  return 0;
+}
+
+// p blocks before its slice ran out: it gets a fresh one.
+static void
+mlfq_yield(struct proc *p)
+{
+  p->mlfq_left = 0;
+}
+
+// Processes waiting on this run queue for more than
+// AGING_CYCLE ticks go to LOTTERY, as in the other classes.
+static void
+mlfq_age(struct runqueue *rq)
+{
+  struct proc *p, *next;
+  int i;
+
+  for(i = 0; i < MLFQ_LEVELS; i++){
+    for(p = rq->mlfq[i].head; p; p = next){
+      next = p->rq_next;
+      if(ticks - p->runnable_since > AGING_CYCLE)
+        promote(p);
+    }
+  }
+}
+
+struct schedclass mlfq_class = {
+  .name = "mlfq",
+  .queue = MLFQ,
+  .quantum = TIME_QUANTUM,
+  .enqueue = mlfq_enqueue,
+  .dequeue = mlfq_dequeue,
+  .pick_next = mlfq_pick_next,
+  .dispatch = mlfq_dispatch,
+  .tick = mlfq_tick,
+  .yield = mlfq_yield,
+  .age = mlfq_age,
+};
+
+// Boost every n ticks.
+int
+set_mlfq_boost(int n)
+{
+  if(n < 1)
+    return -1;
+  boostinterval = n;
+  return 0;
+}
+
+#else
+
+int
+set_mlfq_boost(int n)
+{
+  return -1;
+}
+
+#endif
@@ -17,9 +17,12 @@
 #define SEG_UCODE 3  // user code
 #define SEG_UDATA 4  // user data+stack
 #define SEG_TSS   5  // this process's task state
+#define SEG_KCPU  6  // kernel per-cpu data, in %gs
 
 // cpu->gdt[NSEGS] holds the above segments.
-#define NSEGS     6
+#define NSEGS     7
+
+#define CACHELINE 64  // bytes per cache line
 
 #ifndef __ASSEMBLER__
 // Segment Descriptor
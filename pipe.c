@@ -17,6 +17,8 @@ struct pipe {
   uint nwrite;    // number of bytes written
   int readopen;   // read fd is still open
   int writeopen;  // write fd is still open
+  int rwaiting;   // readers asleep on nread
+  int wwaiting;   // writers asleep on nwrite
 };
 
 int
@@ -34,6 +36,8 @@ pipealloc(struct file **f0, struct file **f1)
   p->writeopen = 1;
   p->nwrite = 0;
   p->nread = 0;
+  p->rwaiting = 0;
+  p->wwaiting = 0;
   initlock(&p->lock, "pipe");
   (*f0)->type = FD_PIPE;
   (*f0)->readable = 1;
@@ -62,10 +66,12 @@ pipeclose(struct pipe *p, int writable)
   acquire(&p->lock);
   if(writable){
     p->writeopen = 0;
-    wakeup(&p->nread);
+    if(p->rwaiting)
+      wakeup(&p->nread);
   } else {
     p->readopen = 0;
-    wakeup(&p->nwrite);
+    if(p->wwaiting)
+      wakeup(&p->nwrite);
   }
   if(p->readopen == 0 && p->writeopen == 0){
     release(&p->lock);
@@ -84,15 +90,27 @@ pipewrite(struct pipe *p, char *addr, int n)
   for(i = 0; i < n; i++){
     while(p->nwrite == p->nread + PIPESIZE){  //DOC: pipewrite-full
       if(p->readopen == 0 || myproc()->killed){
+        // We may have been woken to take a turn; pass it on.
+        if(p->wwaiting)
+          wakeup_one(&p->nwrite);
         release(&p->lock);
         return -1;
       }
-      wakeup(&p->nread);
+      if(p->rwaiting)
+        wakeup_one(&p->nread);
+      p->wwaiting++;
       sleep(&p->nwrite, &p->lock);  //DOC: pipewrite-sleep
+      p->wwaiting--;
     }
     p->data[p->nwrite++ % PIPESIZE] = addr[i];
   }
-  wakeup(&p->nread);  //DOC: pipewrite-wakeup1
+  // Readers and writers wake one waiter at a time, and only
+  // if one is asleep; the next writer only needs waking if
+  // there is still room.
+  if(p->rwaiting)
+    wakeup_one(&p->nread);  //DOC: pipewrite-wakeup1
+  if(p->wwaiting && p->nwrite != p->nread + PIPESIZE)
+    wakeup_one(&p->nwrite);
   release(&p->lock);
   return n;
 }
@@ -105,17 +123,24 @@ piperead(struct pipe *p, char *addr, int n)
   acquire(&p->lock);
   while(p->nread == p->nwrite && p->writeopen){  //DOC: pipe-empty
     if(myproc()->killed){
+      if(p->rwaiting)
+        wakeup_one(&p->nread);
       release(&p->lock);
       return -1;
     }
+    p->rwaiting++;
     sleep(&p->nread, &p->lock); //DOC: piperead-sleep
+    p->rwaiting--;
   }
   for(i = 0; i < n; i++){  //DOC: piperead-copy
     if(p->nread == p->nwrite)
       break;
     addr[i] = p->data[p->nread++ % PIPESIZE];
   }
-  wakeup(&p->nwrite);  //DOC: piperead-wakeup
+  if(p->wwaiting)
+    wakeup_one(&p->nwrite);  //DOC: piperead-wakeup
+  if(p->rwaiting && p->nread != p->nwrite)
+    wakeup_one(&p->nread);
   release(&p->lock);
   return i;
 }
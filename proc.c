@@ -6,10 +6,22 @@
 #include "x86.h"
 #include "proc.h"
 #include "spinlock.h"
+#include "sched.h"
+
+#define SLEEPQ_BITS 6
+#define NSLEEPQ (1 << SLEEPQ_BITS)
+#define NPIDHASH NPROC
 
 struct {
   struct spinlock lock;
   struct proc proc[NPROC];
+  // Sleeping processes, hashed by chan, oldest first.
+  // Linked through rq_next/rq_prev, as they aren't queued.
+  struct proclist sleepq[NSLEEPQ];
+  // Processes with a pid, by pid % NPIDHASH, linked through
+  // pidnext.  Pids are handed out in order, so the chains of
+  // the (at most NPROC) live ones stay short.
+  struct proc *pidhash[NPIDHASH];
 } ptable;
 
 static struct proc *initproc;
@@ -20,10 +32,94 @@ extern void trapret(void);
 
 static void wakeup1(void *chan);
 
+// Add p to the pid index.  The ptable lock must be held.
+static void
+pid_hash(struct proc *p)
+{
+  struct proc **pp = &ptable.pidhash[p->pid % NPIDHASH];
+
+  p->pidnext = *pp;
+  *pp = p;
+}
+
+// Remove p from the pid index.  The ptable lock must be held.
+static void
+pid_unhash(struct proc *p)
+{
+  struct proc **pp;
+
+  for(pp = &ptable.pidhash[p->pid % NPIDHASH]; *pp != p; pp = &(*pp)->pidnext)
+    ;
+  *pp = p->pidnext;
+  p->pidnext = 0;
+}
+
+// Return the process with the given pid, or 0.
+// The ptable lock must be held.
+static struct proc*
+findproc(int pid)
+{
+  struct proc *p;
+
+  if(pid <= 0)
+    return 0;
+  for(p = ptable.pidhash[pid % NPIDHASH]; p && p->pid != pid; p = p->pidnext)
+    ;
+  return p;
+}
+
+// Make p a child of parent.  The ptable lock must be held.
+static void
+add_child(struct proc *parent, struct proc *p)
+{
+  p->parent = parent;
+  p->sibling = parent->children;
+  if(p->sibling)
+    p->sibling->psibling = &p->sibling;
+  p->psibling = &parent->children;
+  parent->children = p;
+}
+
+// Take p off its parent's list of children.
+// The ptable lock must be held.
+static void
+remove_child(struct proc *p)
+{
+  *p->psibling = p->sibling;
+  if(p->sibling)
+    p->sibling->psibling = p->psibling;
+  p->parent = 0;
+  p->sibling = 0;
+  p->psibling = 0;
+}
+
+// The sleep queue that holds processes sleeping on chan.
+static struct proclist*
+sleepq(void *chan)
+{
+  return &ptable.sleepq[((uint)chan * 2654435761U) >> (32 - SLEEPQ_BITS)];
+}
+
+// Mark p RUNNABLE and put it on a run queue, and unless p is
+// the caller, make sure some CPU will pick it up soon.
+// The ptable lock must be held.
+static void
+make_runnable(struct proc *p)
+{
+  p->state = RUNNABLE;
+  enqueue_proc(p);
+  if(p != myproc())
+    kick(p);
+}
+
 void
 pinit(void)
 {
+  struct proc *p;
+
   initlock(&ptable.lock, "ptable");
+  for(p = ptable.proc; p < &ptable.proc[NPROC]; p++)
+    p->slot = p - ptable.proc;
 }
 
 // Must be called with interrupts disabled
@@ -32,19 +128,16 @@ cpuid() {
   return mycpu()-cpus;
 }
 
-// Must be called with interrupts disabled to avoid the caller being
-// rescheduled between reading lapicid and running through the loop.
+// Find this CPU's struct cpu by its local APIC ID, the slow
+// way.  Only seginit() needs this; it sets up %gs for mycpu().
+// Must be called with interrupts disabled.
 struct cpu*
-mycpu(void)
+lapiccpu(void)
 {
   int apicid, i;
 
-  if(readeflags()&FL_IF)
-    panic("mycpu called with interrupts enabled\n");
-
   apicid = lapicid();
-  // APIC IDs are not guaranteed to be contiguous. Maybe we should have
-  // a reverse map, or reserve a register to store &cpus[i].
+  // APIC IDs are not guaranteed to be contiguous.
   for (i = 0; i < ncpu; ++i) {
     if (cpus[i].apicid == apicid)
       return &cpus[i];
@@ -52,16 +145,27 @@ mycpu(void)
   panic("unknown apicid\n");
 }
 
-// Disable interrupts so that we are not rescheduled
-// while reading proc from the cpu structure
+// Must be called with interrupts disabled to avoid the caller being
+// rescheduled onto another CPU while using the result.
+struct cpu*
+mycpu(void)
+{
+  struct cpu *c;
+
+  if(readeflags()&FL_IF)
+    panic("mycpu called with interrupts enabled\n");
+  asm volatile("movl %%gs:0, %0" : "=r" (c));
+  return c;
+}
+
+// One load from %gs:4, so no need to disable interrupts: even if
+// we are rescheduled right after it, the process running on
+// whichever CPU we were on was us.
 struct proc*
 myproc(void) {
-  struct cpu *c;
   struct proc *p;
-  pushcli();
-  c = mycpu();
-  p = c->proc;
-  popcli();
+
+  asm volatile("movl %%gs:4, %0" : "=r" (p) : : "memory");
   return p;
 }
 
@@ -88,11 +192,18 @@ allocproc(void)
 found:
   p->state = EMBRYO;
   p->pid = nextpid++;
-  p->queue_num = HRRN;
-
-  p->cycles = 1;
+  pid_hash(p);
+  p->queue_num = NEWPROC_QUEUE;
+  p->cpu = -1;
+  p->vcpu = -1;
+  p->affinity = (1 << ncpu) - 1;
+  p->lastcpu = -1;
+  p->migrations = 0;
+  p->mlfq_level = 0;
+  p->mlfq_left = 0;
+
+  p->cycles = CYCLES_SCALE;
   p->ticket = 10;
-  p->waiting_time = 0;
   acquire(&tickslock);
   p->arrival_time = ticks;
   release(&tickslock);
@@ -101,7 +212,10 @@ found:
 
   // Allocate kernel stack.
   if((p->kstack = kalloc()) == 0){
+    acquire(&ptable.lock);
+    pid_unhash(p);
     p->state = UNUSED;
+    release(&ptable.lock);
     return 0;
   }
   sp = p->kstack + KSTACKSIZE;
@@ -156,7 +270,7 @@ userinit(void)
   // because the assignment might not be atomic.
   acquire(&ptable.lock);
 
-  p->state = RUNNABLE;
+  make_runnable(p);
 
   release(&ptable.lock);
 }
@@ -201,11 +315,13 @@ fork(void)
   if((np->pgdir = copyuvm(curproc->pgdir, curproc->sz)) == 0){
     kfree(np->kstack);
     np->kstack = 0;
+    acquire(&ptable.lock);
+    pid_unhash(np);
     np->state = UNUSED;
+    release(&ptable.lock);
     return -1;
   }
   np->sz = curproc->sz;
-  np->parent = curproc;
   *np->tf = *curproc->tf;
 
   // Clear %eax so that fork returns 0 in the child.
@@ -220,9 +336,16 @@ fork(void)
 
   pid = np->pid;
 
+  np->affinity = curproc->affinity;
+
+  // MLFQ is inherited, so a shell in MLFQ keeps its jobs there.
+  if(curproc->queue_num == MLFQ)
+    np->queue_num = MLFQ;
+
   acquire(&ptable.lock);
 
-  np->state = RUNNABLE;
+  add_child(curproc, np);
+  make_runnable(np);
 
   release(&ptable.lock);
 
@@ -237,7 +360,7 @@ exit(void)
 {
   struct proc *curproc = myproc();
   struct proc *p;
-  int fd;
+  int fd, zombies;
 
   if(curproc == initproc)
     panic("init exiting");
@@ -261,13 +384,17 @@ exit(void)
   wakeup1(curproc->parent);
 
   // Pass abandoned children to init.
-  for(p = ptable.proc; p < &ptable.proc[NPROC]; p++){
-    if(p->parent == curproc){
-      p->parent = initproc;
-      if(p->state == ZOMBIE)
-        wakeup1(initproc);
-    }
+  zombies = 0;
+  while((p = curproc->children) != 0){
+    remove_child(p);
+    add_child(initproc, p);
+    if(p->state == ZOMBIE)
+      zombies = 1;
   }
+  if(zombies)
+    wakeup1(initproc);
+
+  sched_exit(curproc);
 
   // Jump into the scheduler, never to return.
   curproc->state = ZOMBIE;
@@ -286,20 +413,18 @@ wait(void)
 
   acquire(&ptable.lock);
   for(;;){
-    // Scan through table looking for exited children.
-    havekids = 0;
-    for(p = ptable.proc; p < &ptable.proc[NPROC]; p++){
-      if(p->parent != curproc)
-        continue;
-      havekids = 1;
+    // Scan through our children looking for exited ones.
+    havekids = curproc->children != 0;
+    for(p = curproc->children; p; p = p->sibling){
       if(p->state == ZOMBIE){
         // Found one.
         pid = p->pid;
         kfree(p->kstack);
         p->kstack = 0;
         freevm(p->pgdir);
+        pid_unhash(p);
+        remove_child(p);
         p->pid = 0;
-        p->parent = 0;
         p->name[0] = 0;
         p->killed = 0;
         p->state = UNUSED;
@@ -328,156 +453,31 @@ wait(void)
 //  - eventually that process transfers control
 //      via swtch back to the scheduler.
 
-struct proc* 
-get_lottery_sched_proc(void)
-{
-  struct proc *p;
-  uint total_tickets = 0;
-  uint cur_tickets = 0;
-  uint goal_ticket;
-  uint random;
-  Bool has_proc = FALSE;
-
-  for(p = ptable.proc; p < &ptable.proc[NPROC]; p++){
-    if(p->state != RUNNABLE || p->queue_num != LOTTERY)
-      continue;
-
-    total_tickets += p->ticket;
-    has_proc = TRUE;
-  }
-
-  //acquire(&tickslock);
-  //random = ticks;
-  //release(&tickslock);
-
-  if(has_proc){
-    random = ticks;
-    goal_ticket = (random) % total_tickets;
-    for(p = ptable.proc; p < &ptable.proc[NPROC]; p++){
-      if(p->state != RUNNABLE || p->queue_num != LOTTERY)
-        continue;
-
-      cur_tickets += p->ticket;
-    
-      if(goal_ticket < cur_tickets){
-        return p;
-      }
-    }
-  }
-  return NOTHING;
-}
-
-struct proc*
-get_round_robin_sched_proc(void)
-{
-  struct proc *p;
-  struct proc *target_proc;
-  Bool has_proc = FALSE;
-  for(p = ptable.proc; p < &ptable.proc[NPROC]; p++){
-    if(p->state != RUNNABLE || p->queue_num != ROUND_ROBIN)
-        continue;
-    if(has_proc)
-    {
-        if(p->arrival_time < target_proc->arrival_time)
-          target_proc = p;
-    }
-    else
-    {
-        target_proc = p;
-        has_proc = TRUE;
-    }
-  }
-
-  if(has_proc)
-    return target_proc;
-
-  return NOTHING;
-}
-
-double calculate_hrrn(int arrival_time, int cycles)
-{
-    //acquire(&tickslock);
-    int current_time = ticks;
-    //release(&tickslock);
-    int waiting_time = current_time - arrival_time;
-    // cprintf("waiting time = %d, cycles = %d\n", waiting_time, cycles);
-    double hrrn = waiting_time * 1.0 / cycles ;
-    return hrrn;
-}
-
-struct proc*
-get_hrrn_sched_proc(void)
-{
-  struct proc *current_proc;
-  struct proc *max_ratio_proc = 0;
-  double max_ratio = 0.0;
-
-  for(current_proc = ptable.proc; current_proc < &ptable.proc[NPROC]; ++current_proc){
-    if(current_proc->state != RUNNABLE || current_proc->queue_num != HRRN)
-      continue;
-
-    double current_ratio = calculate_hrrn(current_proc->arrival_time, current_proc->cycles);
-
-    if (current_ratio > max_ratio)
-    {
-      max_ratio = current_ratio;
-      max_ratio_proc = current_proc;
-    }
-  }
-
-  return max_ratio_proc;
-}
-
-void
-update_waiting_times()
-{
-  struct proc *p;
-
-  for(p = ptable.proc; p < &ptable.proc[NPROC]; p++){
-    if(p->state != RUNNABLE)
-      continue;
-
-    p->waiting_time++;
-  }
-}
-
-void
-check_aging()
-{
-  struct proc *p;
-
-  for(p = ptable.proc; p < &ptable.proc[NPROC]; p++){
-    if(p->state != RUNNABLE)
-      continue;
-
-    if (p->waiting_time > AGING_CYCLE)
-    {
-        p->queue_num = LOTTERY;
-        p->waiting_time = 0;
-    }
-  }
-}
-
 void
 scheduler(void)
 {
   struct proc *p;
   struct cpu *c = mycpu();
+  uint t0;
   c->proc = 0;
 
   for(;;){
     // Enable interrupts on this processor.
     sti();
 
-    acquire(&ptable.lock);
-
-    p = get_lottery_sched_proc();
+    // Halt rather than spin on ptable.lock, which the
+    // busy CPUs need, until some run queue has work for us.
+    if(!have_runnable(c - cpus)){
+      idle(c);
+      continue;
+    }
 
-    if(p == NOTHING)
-      p = get_round_robin_sched_proc();
+    acquire(&ptable.lock);
 
-    if(p == NOTHING)
-      p = get_hrrn_sched_proc();
+    t0 = rdtsc();
+    p = pick_next_proc(c);
+    runqueues[c-cpus].pick_cycles += rdtsc() - t0;
+    runqueues[c-cpus].picks++;
 
     // Switch to chosen process.  It is the process's job
     // to release ptable.lock and then reacquire it
@@ -487,22 +487,14 @@ scheduler(void)
         c->proc = p;
         switchuvm(p);
         p->state = RUNNING;
-        p->cycles += 0.1;
-        update_waiting_times();
-        p->waiting_time = 0;
-        check_aging();
+        p->cycles++;  // 0.1 cycle
+        start_slice(p);
         swtch(&(c->scheduler), p->context);
         switchkvm();
 
         // Process is done running for now.
         // It should have changed its p->state before coming back.
         c->proc = 0;
-        if (p->state == RUNNABLE && p->queue_num == ROUND_ROBIN)
-        {
-            //acquire(&tickslock);
-            p->arrival_time = ticks;
-            //release(&tickslock);
-        }
     }
 
     release(&ptable.lock);
@@ -541,7 +533,7 @@ void
 yield(void)
 {
   acquire(&ptable.lock);  //DOC: yieldlock
-  myproc()->state = RUNNABLE;
+  make_runnable(myproc());
   sched();
   release(&ptable.lock);
 }
@@ -593,6 +585,8 @@ sleep(void *chan, struct spinlock *lk)
   // Go to sleep.
   p->chan = chan;
   p->state = SLEEPING;
+  proclist_append(sleepq(chan), p);
+  sched_yield(p);
 
   sched();
 
@@ -607,16 +601,28 @@ sleep(void *chan, struct spinlock *lk)
 }
 
 //PAGEBREAK!
+// Take sleeping process p off its sleep queue and make it
+// runnable.  The ptable lock must be held.
+static void
+wakeproc(struct proc *p)
+{
+  proclist_remove(sleepq(p->chan), p);
+  p->waketsc = rdtsc() | 1;  // never 0
+  make_runnable(p);
+}
+
 // Wake up all processes sleeping on chan.
 // The ptable lock must be held.
 static void
 wakeup1(void *chan)
 {
-  struct proc *p;
+  struct proc *p, *next;
 
-  for(p = ptable.proc; p < &ptable.proc[NPROC]; p++)
-    if(p->state == SLEEPING && p->chan == chan)
-      p->state = RUNNABLE;
+  for(p = sleepq(chan)->head; p; p = next){
+    next = p->rq_next;
+    if(p->chan == chan)
+      wakeproc(p);
+  }
 }
 
 // Wake up all processes sleeping on chan.
@@ -628,6 +634,25 @@ wakeup(void *chan)
   release(&ptable.lock);
 }
 
+// Wake up only the process that has slept longest on chan, for
+// waiters that can't all proceed at once.  Whoever it wakes
+// should pass the baton on (call wakeup_one again) if there is
+// still something left for the next waiter.
+void
+wakeup_one(void *chan)
+{
+  struct proc *p;
+
+  acquire(&ptable.lock);
+  for(p = sleepq(chan)->head; p; p = p->rq_next){
+    if(p->chan == chan){
+      wakeproc(p);
+      break;
+    }
+  }
+  release(&ptable.lock);
+}
+
 // Kill the process with the given pid.
 // Process won't exit until it returns
 // to user space (see trap in trap.c).
@@ -637,18 +662,16 @@ kill(int pid)
   struct proc *p;
 
   acquire(&ptable.lock);
-  for(p = ptable.proc; p < &ptable.proc[NPROC]; p++){
-    if(p->pid == pid){
-      p->killed = 1;
-      // Wake process from sleep if necessary.
-      if(p->state == SLEEPING)
-        p->state = RUNNABLE;
-      release(&ptable.lock);
-      return 0;
-    }
+  if((p = findproc(pid)) == 0){
+    release(&ptable.lock);
+    return -1;
   }
+  p->killed = 1;
+  // Wake process from sleep if necessary.
+  if(p->state == SLEEPING)
+    wakeproc(p);
   release(&ptable.lock);
-  return -1;
+  return 0;
 }
 
 //PAGEBREAK: 36
@@ -693,17 +716,125 @@ set_proc_queue(int pid, int dest_queue)
 {
   struct proc *p;
 
+  // EDF needs parameters; see set_proc_rt().
+  if(sched_class(dest_queue) == 0 || dest_queue == EDF)
+    return -1;
+
   acquire(&ptable.lock);
-  for(p = ptable.proc; p < &ptable.proc[NPROC]; p++){
-    if(p->pid == pid){
-      p->queue_num = dest_queue;
-      p->waiting_time = 0;
-      release(&ptable.lock);
-      return 0;
-    }
+  if((p = findproc(pid)) == 0){
+    release(&ptable.lock);
+    return -1;
+  }
+  change_queue(p, dest_queue);
+  release(&ptable.lock);
+  return 0;
+}
+
+int
+set_proc_rt(int pid, int period, int runtime, int deadline)
+{
+  struct proc *p;
+  int r;
+
+  acquire(&ptable.lock);
+  if((p = findproc(pid)) == 0){
+    release(&ptable.lock);
+    return -1;
+  }
+  r = edf_admit(p, period, runtime, deadline);
+  release(&ptable.lock);
+  return r;
+}
+
+// Called from every CPU's timer interrupt.  Every
+// BALANCE_INTERVAL ticks, even out this CPU's run queue
+// with the others.
+void
+balancetick(void)
+{
+  int cpu = cpuid();
+
+  if(!balance_due(cpu))
+    return;
+  acquire(&ptable.lock);
+  balance(cpu);
+  release(&ptable.lock);
+}
+
+// Restrict pid to the CPUs in mask.
+int
+set_affinity(int pid, uint mask)
+{
+  struct proc *p;
+  int r, moved;
+
+  acquire(&ptable.lock);
+  if((p = findproc(pid)) == 0){
+    release(&ptable.lock);
+    return -1;
+  }
+  r = set_cpu_mask(p, mask);
+  moved = r == 0 && p == myproc() && !can_run(p, cpuid());
+  release(&ptable.lock);
+  // Get off this CPU now rather than at the end of the slice.
+  if(moved)
+    yield();
+  return r;
+}
+
+int
+get_affinity(int pid)
+{
+  struct proc *p;
+  int mask;
+
+  acquire(&ptable.lock);
+  if((p = findproc(pid)) == 0){
+    release(&ptable.lock);
+    return -1;
+  }
+  mask = p->affinity;
+  release(&ptable.lock);
+  return mask;
+}
+
+int
+get_migrations(int pid)
+{
+  struct proc *p;
+  int n;
+
+  acquire(&ptable.lock);
+  if((p = findproc(pid)) == 0){
+    release(&ptable.lock);
+    return -1;
   }
+  n = p->migrations;
   release(&ptable.lock);
-  return -1;
+  return n;
+}
+
+int
+set_queue_mode(int queue, int mode)
+{
+  int r;
+
+  acquire(&ptable.lock);
+  r = sched_setmode(queue, mode);
+  release(&ptable.lock);
+  return r;
+}
+
+// The ptable lock must be held.
+static void
+setticket(struct proc *p, int value)
+{
+  if(p->state == RUNNABLE){
+    dequeue_proc(p);
+    p->ticket = value;
+    requeue_proc(p);
+  } else
+    p->ticket = value;
 }
 
 int
@@ -711,16 +842,54 @@ set_proc_ticket(int pid, int value)
 {
   struct proc *p;
 
+  if(value < 0)
+    return -1;
+
+  acquire(&ptable.lock);
+  if((p = findproc(pid)) == 0){
+    release(&ptable.lock);
+    return -1;
+  }
+  setticket(p, value);
+  release(&ptable.lock);
+  return 0;
+}
+
+// Apply n set_proc_queue/set_proc_ticket updates under one
+// acquisition of the ptable lock.  Every entry is checked
+// first; if any is invalid, its status says so and nothing
+// changes.  Returns 0, or -1 if some entry was invalid.
+int
+sched_setparams(struct sched_param *sp, int n)
+{
+  struct proc *p;
+  int i, bad;
+
+  bad = 0;
   acquire(&ptable.lock);
-  for(p = ptable.proc; p < &ptable.proc[NPROC]; p++){
-    if(p->pid == pid){
-      p->ticket = value;
-      release(&ptable.lock);
-      return 0;
+  for(i = 0; i < n; i++){
+    sp[i].status = 0;
+    if(findproc(sp[i].pid) == 0 ||
+       (sp[i].queue != SCHED_KEEP &&
+        (sched_class(sp[i].queue) == 0 || sp[i].queue == EDF)) ||
+       (sp[i].ticket != SCHED_KEEP && sp[i].ticket < 0)){
+      sp[i].status = -1;
+      bad = 1;
     }
   }
+  if(bad){
+    release(&ptable.lock);
+    return -1;
+  }
+  for(i = 0; i < n; i++){
+    p = findproc(sp[i].pid);
+    if(sp[i].queue != SCHED_KEEP)
+      change_queue(p, sp[i].queue);
+    if(sp[i].ticket != SCHED_KEEP)
+      setticket(p, sp[i].ticket);
+  }
   release(&ptable.lock);
-  return -1;
+  return 0;
 }
 
 void print_spaces(int remaining)
@@ -781,31 +950,16 @@ int integer_to_string(int x, char str[], int d)
     return i; 
 } 
 
-int pow(int x, unsigned int y) 
-{ 
-    if (y == 0) 
-        return 1; 
-    else if (y % 2 == 0) 
-        return pow(x, y / 2) * pow(x, y / 2); 
-    else
-        return x * pow(x, y / 2) * pow(x, y / 2); 
-} 
-  
-void float_to_string(float number, char* res, int precision) 
-{ 
-    int ipart = (int)number; 
-  
-    float fpart = number - (float)ipart; 
-  
-    int i = integer_to_string(ipart, res, 0); 
-  
-    if (precision != 0) { 
-        res[i] = '.'; 
-  
-        fpart = fpart * pow(10, precision); 
-  
-        integer_to_string((int)fpart, res + i + 1, precision); 
-    } 
+// Format value, a fixed-point number in 1/scale units
+// with scale = 10^precision, as a decimal string.
+void fixed_to_string(uint value, uint scale, char* res, int precision)
+{
+    int i = integer_to_string(value / scale, res, 0);
+
+    if (precision != 0) {
+        res[i] = '.';
+        integer_to_string(value % scale, res + i + 1, precision);
+    }
 }
 
 int
@@ -868,7 +1022,7 @@ print_processes(void)
     print_spaces(max_column_lens[STATE] - strlen(state));
     cprintf("%d", p->queue_num);
     print_spaces(max_column_lens[QUEUE_NUM] - count_num_of_digits(p->queue_num));
-    if (p->queue_num != LOTTERY)
+    if (p->queue_num != LOTTERY && p->queue_num != CFS)
     {
       cprintf("--");
       ticket_len = 2;
@@ -881,15 +1035,13 @@ print_processes(void)
     print_spaces(max_column_lens[TICKET] - ticket_len);
     
     char cycles_str[30];
-    float_to_string(p->cycles, cycles_str, CYCLES_PRECISION);
+    fixed_to_string(p->cycles, CYCLES_SCALE, cycles_str, CYCLES_PRECISION);
 
     cprintf("%s", cycles_str);
     print_spaces(max_column_lens[CYCLES] - strlen(cycles_str));
     
-    double hrrn_ratio = calculate_hrrn(p->arrival_time, p->cycles);
-
     char hrrn_str[30];
-    float_to_string(hrrn_ratio, hrrn_str, HRRN_PRECISION);
+    fixed_to_string(hrrn_ratio(p), HRRN_SCALE, hrrn_str, HRRN_PRECISION);
 
     cprintf("%s\n", hrrn_str);
     cprintf("\n");
@@ -1,8 +1,28 @@
-#define AGING_CYCLE 2500
+#define AGING_CYCLE 2500   // ticks runnable before promotion to LOTTERY
+#define AGING_INTERVAL 10  // ticks between aging passes
+#define BALANCE_INTERVAL 4 // ticks between load balancing passes, per CPU
 #define TIME_QUANTUM 2
+#define MLFQ_LEVELS 3      // MLFQ priority levels
+#define MLFQ_BOOST 100     // default ticks between MLFQ boosts
 
-// Per-CPU state
+// A kernel built with SCHED_ONLY=<queue> (make SCHEDPOLICY=...)
+// has just that one scheduling class, and every process is in it.
+#ifdef SCHED_ONLY
+#define SCHED_HAS(q) ((q) == SCHED_ONLY)
+#define NEWPROC_QUEUE SCHED_ONLY
+#define EXEC_QUEUE SCHED_ONLY
+#else
+#define SCHED_HAS(q) 1
+#define NEWPROC_QUEUE HRRN     // queue of new processes
+#define EXEC_QUEUE LOTTERY     // queue a process moves to on exec
+#endif
+
+// Per-CPU state.  Each CPU's %gs segment covers the first two
+// fields (see seginit), so mycpu() and myproc() are one load.
+// Aligned to a cache line so CPUs don't write each other's lines.
 struct cpu {
+  struct cpu *self;            // &cpus[i], at %gs:0
+  struct proc *proc;           // The process running on this cpu or null, at %gs:4
   uchar apicid;                // Local APIC ID
   struct context *scheduler;   // swtch() here to enter scheduler
   struct taskstate ts;         // Used by x86 to find stack for interrupt
@@ -10,8 +30,8 @@ struct cpu {
   volatile uint started;       // Has the CPU started?
   int ncli;                    // Depth of pushcli nesting.
   int intena;                  // Were interrupts enabled before pushcli?
-  struct proc *proc;           // The process running on this cpu or null
-};
+  uint randstate;              // Random number generator state (rand.c)
+} __attribute__((aligned(CACHELINE)));
 
 extern struct cpu cpus[NCPU];
 extern int ncpu;
@@ -37,6 +57,18 @@ struct context {
 
 enum procstate { UNUSED, EMBRYO, SLEEPING, RUNNABLE, RUNNING, ZOMBIE };
 
+// Red-black tree node and tree (rbtree.c).
+struct rbnode {
+  struct rbnode *parent;
+  struct rbnode *child[2];     // Left, right
+  int red;
+};
+
+struct rbtree {
+  struct rbnode *root;
+  struct rbnode *leftmost;     // Smallest node, 0 if empty
+};
+
 // Per-process state
 struct proc {
   uint sz;                     // Size of process memory (bytes)
@@ -44,7 +76,11 @@ struct proc {
   char *kstack;                // Bottom of kernel stack for this process
   enum procstate state;        // Process state
   int pid;                     // Process ID
+  struct proc *pidnext;        // Next in pid hash chain (proc.c)
   struct proc *parent;         // Parent process
+  struct proc *children;       // First child
+  struct proc *sibling;        // Next child of the same parent
+  struct proc **psibling;      // Link that points at this child
   struct trapframe *tf;        // Trap frame for current syscall
   struct context *context;     // swtch() here to run process
   void *chan;                  // If non-zero, sleeping on chan
@@ -54,10 +90,125 @@ struct proc {
   char name[16];               // Process name (debugging)
   int queue_num;               // Process Queue Number
   uint ticket;                 // Process Ticket
-  float cycles;                  // Process Cycles
+  uint comp_tickets;           // Compensation tickets until next dispatch
+  uint cycles;                 // Process Cycles, in 1/CYCLES_SCALE units
   int arrival_time;           // Process Arraval time
-  float hrrn;                  // Process HRRN Ratio
-  int waiting_time;            // Process waited time to be called
+  uint hrrn;                   // HRRN ratio at last refresh, in 1/HRRN_SCALE units
+  uint runnable_since;         // ticks when last made RUNNABLE
+  int slice;                   // Timer ticks left in current time slice
+  int slot;                    // Index in the process table
+  int cpu;                     // CPU whose run queue holds p, -1 if none yet
+  uint affinity;               // Bitmap of CPUs p may run on
+  int lastcpu;                 // CPU p last ran on, -1 if none yet
+  uint migrations;             // Times p ran on a different CPU than before
+  uint lastrun;                // ticks when last dispatched
+  uint waketsc;                // TSC at wakeup, 0 once dispatched
+  struct proc *rq_next;        // Run queue links while RUNNABLE, sleep queue links while SLEEPING
+  struct proc *rq_prev;
+  uint vruntime;               // CFS virtual runtime
+  int vcpu;                    // CPU whose min_vruntime vruntime follows, -1 if none
+  struct rbnode rb;            // CFS run queue node, while RUNNABLE
+  uint pass;                   // Stride scheduling pass
+  uint stride;                 // Pass advance per tick
+  int heapidx;                 // Index in the stride heap, while RUNNABLE
+  int rt_period;               // EDF parameters, in ticks
+  int rt_runtime;
+  int rt_reldeadline;
+  uint rt_util;                // runtime/period, as admitted
+  uint rt_release;             // Start of the current period
+  uint rt_deadline;            // Absolute deadline in the current period
+  int rt_budget;               // Ticks left to run in the current period
+  int rt_throttled;            // Out of budget until the next period
+  int mlfq_level;              // MLFQ level, 0 highest
+  int mlfq_left;               // Ticks left of the slice at that level, 0 if fresh
+  uint mlfq_gen;               // MLFQ boost generation at last enqueue
+};
+
+// List of runnable processes, linked through rq_next/rq_prev.
+struct proclist {
+  struct proc *head;
+  struct proc *tail;
+};
+
+// Per-CPU run queue, with the state of every scheduling class.
+// Protected by ptable.lock (see sched.c).
+struct runqueue {
+  // LOTTERY: Fenwick tree of ticket counts by process slot.
+  uint lottery_tree[NPROC+1];  // Ticket prefix sums, 1-based
+  uint lottery_tickets[NPROC]; // Tickets each slot entered with
+  struct proc *lottery_proc[NPROC];
+  uint total_tickets;
+  // LOTTERY in MODE_STRIDE: min-heap by pass.
+  struct proc *stride_heap[NPROC];
+  int stride_n;
+  uint stride_pass;            // Pass of the last process picked
+
+  // ROUND_ROBIN: FIFO.
+  struct proclist rr;
+
+  // MLFQ: a FIFO per level.
+  struct proclist mlfq[MLFQ_LEVELS];
+
+  // CFS: ordered by virtual runtime.
+  struct rbtree cfs;
+  uint min_vruntime;           // Never decreases
+
+  // EDF: ready processes by deadline, and throttled ones.
+  struct proclist edf;
+  struct proclist edf_throttled;
+  volatile uint edf_release;   // No throttled process is due before this
+
+  // HRRN: sorted by response ratio, highest first.
+  struct proclist hrrn;
+  uint hrrn_stamp;             // ticks at last refresh
+
+  uint active;                 // Bitmap of non-empty classes, by priority
+  int count[NQUEUE+1];         // Runnable processes in each queue
+  uint aging_stamp;            // ticks at last aging pass
+  volatile int nrunnable;      // Total; may be read without the lock
+  volatile int ncanrun[NCPU];  // How many of them each CPU may run, less
+                               // throttled EDF ones; ditto
+  uint load;                   // Total tickets of queued processes
+  uint balance_stamp;          // ticks at last load balancing pass
+  volatile uint halted;        // CPU is halted in idle()
+  uint picks;                  // Statistics, see struct cpustat
+  uint pick_cycles;
+  uint steals;
+  uint idle_ticks;
+  uint idle_cycles;
+  uint balanced;
+  uint wakelat[NWAKELAT];
+} __attribute__((aligned(CACHELINE)));
+
+extern struct runqueue runqueues[NCPU];
+
+// A scheduling class implements one of the queues that
+// set_proc_queue() can put a process in.  The core scheduler
+// (sched.c) keeps the classes in priority order and calls them
+// with ptable.lock held.
+struct schedclass {
+  char *name;
+  int queue;                   // Queue number, e.g. LOTTERY
+  int quantum;                 // Time slice, in timer ticks
+  void (*enqueue)(struct runqueue*, struct proc*);
+  void (*dequeue)(struct runqueue*, struct proc*);
+  // Return the process for cpu to run next, leaving it queued.
+  // It must be one that can run on cpu; see can_run().
+  struct proc* (*pick_next)(struct runqueue*, int);
+  // p is about to run: set p->slice (optional, default quantum).
+  void (*dispatch)(struct proc*);
+  // Timer tick while p is running (optional).
+  // Returns 1 if p must give up the CPU now.
+  int (*tick)(struct proc*);
+  // p is giving up the CPU before its slice ran out (optional).
+  void (*yield)(struct proc*);
+  // Promote processes that have waited too long (optional).
+  void (*age)(struct runqueue*);
+  // Change the class's mode, e.g. MODE_STRIDE (optional).
+  int (*setmode)(int);
+  // p is leaving the class or exiting (optional).
+  void (*leave)(struct proc*);
+  int prio;                    // Position in priority order, set by schedinit
 };
 
 // Process memory is laid out contiguously, low addresses first:
@@ -0,0 +1,52 @@
+// Per-CPU pseudo-random numbers for the lottery scheduler.
+// Each CPU runs its own xorshift32 generator, so CPUs drawing
+// in the same tick get different numbers and never share a
+// cache line of generator state.
+
+#include "types.h"
+#include "defs.h"
+#include "param.h"
+#include "memlayout.h"
+#include "mmu.h"
+#include "x86.h"
+#include "proc.h"
+
+// Scramble x into a non-zero generator state.
+static uint
+mix(uint x)
+{
+  x ^= x >> 16;
+  x *= 0x45d9f3b;
+  x ^= x >> 16;
+  x *= 0x45d9f3b;
+  x ^= x >> 16;
+  return x ? x : 1;
+}
+
+// Return the next number from this CPU's generator.
+// Must be called with interrupts disabled.
+uint
+rand(void)
+{
+  struct cpu *c = mycpu();
+  uint x;
+
+  if((x = c->randstate) == 0)
+    x = mix(rdtsc() + (c - cpus));  // not seeded yet
+  x ^= x << 13;
+  x ^= x >> 17;
+  x ^= x << 5;
+  c->randstate = x;
+  return x;
+}
+
+// Reseed every CPU's generator from seed, so that a run
+// can be repeated.
+void
+srand(uint seed)
+{
+  int i;
+
+  for(i = 0; i < ncpu; i++)
+    cpus[i].randstate = mix(seed + i);
+}
@@ -0,0 +1,177 @@
+// Red-black trees.
+//
+// The nodes are embedded in the structures they order and
+// carry no key: the caller walks down from the root comparing
+// its own keys, then hands rb_insert() the parent and the side
+// to hang the new node on.  The tree caches its leftmost node,
+// so finding the minimum is O(1).
+
+#include "types.h"
+#include "defs.h"
+#include "param.h"
+#include "memlayout.h"
+#include "mmu.h"
+#include "proc.h"
+
+// Make x's child on side dir (0 left, 1 right) its parent.
+static void
+rotate(struct rbtree *t, struct rbnode *x, int dir)
+{
+  struct rbnode *y = x->child[dir];
+
+  x->child[dir] = y->child[!dir];
+  if(y->child[!dir])
+    y->child[!dir]->parent = x;
+  y->parent = x->parent;
+  if(x->parent == 0)
+    t->root = y;
+  else
+    x->parent->child[x == x->parent->child[1]] = y;
+  y->child[!dir] = x;
+  x->parent = y;
+}
+
+// Link n as the child on side dir of parent (or as the root if
+// parent is 0) and rebalance.
+void
+rb_insert(struct rbtree *t, struct rbnode *parent, int dir, struct rbnode *n)
+{
+  struct rbnode *g, *u;
+  int side;
+
+  n->parent = parent;
+  n->child[0] = n->child[1] = 0;
+  n->red = 1;
+  if(parent == 0)
+    t->root = n;
+  else
+    parent->child[dir] = n;
+  if(t->leftmost == 0 || (parent == t->leftmost && dir == 0))
+    t->leftmost = n;
+
+  while((parent = n->parent) && parent->red){
+    g = parent->parent;
+    side = parent == g->child[1];
+    u = g->child[!side];
+    if(u && u->red){
+      parent->red = u->red = 0;
+      g->red = 1;
+      n = g;
+      continue;
+    }
+    if(n == parent->child[!side]){
+      rotate(t, parent, !side);
+      n = parent;
+      parent = n->parent;
+    }
+    parent->red = 0;
+    g->red = 1;
+    rotate(t, g, side);
+  }
+  t->root->red = 0;
+}
+
+// Return the node after n in order, or 0.
+struct rbnode*
+rb_next(struct rbnode *n)
+{
+  struct rbnode *p;
+
+  if(n->child[1]){
+    for(n = n->child[1]; n->child[0]; n = n->child[0])
+      ;
+    return n;
+  }
+  while((p = n->parent) && n == p->child[1])
+    n = p;
+  return p;
+}
+
+// Put n in o's place in the tree, taking over its links and color.
+static void
+replace(struct rbtree *t, struct rbnode *o, struct rbnode *n)
+{
+  *n = *o;
+  if(o->parent == 0)
+    t->root = n;
+  else
+    o->parent->child[o == o->parent->child[1]] = n;
+  if(n->child[0])
+    n->child[0]->parent = n;
+  if(n->child[1])
+    n->child[1]->parent = n;
+}
+
+void
+rb_erase(struct rbtree *t, struct rbnode *n)
+{
+  struct rbnode *child, *parent, *s, *succ;
+  int red, side;
+
+  if(n == t->leftmost)
+    t->leftmost = rb_next(n);
+
+  // Reduce to removing a node with at most one child: if n has
+  // two, unlink its successor instead and put that in n's place.
+  succ = 0;
+  if(n->child[0] && n->child[1]){
+    succ = rb_next(n);
+    child = succ->child[1];
+    parent = succ->parent;
+    red = succ->red;
+    if(parent == n)
+      parent = succ;
+    side = parent == succ;
+    succ->parent->child[succ == succ->parent->child[1]] = child;
+    if(child)
+      child->parent = succ->parent;
+    replace(t, n, succ);
+  } else {
+    child = n->child[0] ? n->child[0] : n->child[1];
+    parent = n->parent;
+    red = n->red;
+    side = parent && n == parent->child[1];
+    if(child)
+      child->parent = parent;
+    if(parent == 0)
+      t->root = child;
+    else
+      parent->child[side] = child;
+  }
+
+  if(red)
+    return;
+
+  // child, on side of parent, is short one black node.
+  while(parent && (child == 0 || !child->red)){
+    s = parent->child[!side];
+    if(s->red){
+      s->red = 0;
+      parent->red = 1;
+      rotate(t, parent, !side);
+      s = parent->child[!side];
+    }
+    if((s->child[0] == 0 || !s->child[0]->red) &&
+       (s->child[1] == 0 || !s->child[1]->red)){
+      s->red = 1;
+      child = parent;
+      parent = child->parent;
+      side = parent && child == parent->child[1];
+      continue;
+    }
+    if(s->child[!side] == 0 || !s->child[!side]->red){
+      s->child[side]->red = 0;
+      s->red = 1;
+      rotate(t, s, side);
+      s = parent->child[!side];
+    }
+    s->red = parent->red;
+    parent->red = 0;
+    s->child[!side]->red = 0;
+    rotate(t, parent, !side);
+    child = t->root;
+    break;
+  }
+  if(child)
+    child->red = 0;
+}
@@ -0,0 +1,62 @@
+// ROUND_ROBIN scheduling class.
+//
+// A FIFO: processes are queued in order of when they became
+// runnable, so the head is the one that has waited longest,
+// with ties broken by the order they were queued.
+
+#include "types.h"
+#include "defs.h"
+#include "param.h"
+#include "memlayout.h"
+#include "mmu.h"
+#include "proc.h"
+#include "sched.h"
+
+#if SCHED_HAS(ROUND_ROBIN)
+
+// Newly runnable processes go at the tail.  One moved from
+// another CPU may have waited longer than some already here.
+static void
+rr_enqueue(struct runqueue *rq, struct proc *p)
+{
+  struct proc *q;
+
+  for(q = rq->rr.tail; q && (int)(p->runnable_since - q->runnable_since) < 0; q = q->rq_prev)
+    ;
+  proclist_insert(&rq->rr, q, p);
+}
+
+static void
+rr_dequeue(struct runqueue *rq, struct proc *p)
+{
+  proclist_remove(&rq->rr, p);
+}
+
+static struct proc*
+rr_pick_next(struct runqueue *rq, int cpu)
+{
+  return proclist_first(&rq->rr, cpu);
+}
+
+// The list is in order of runnable_since, so only its head
+// needs checking.
+static void
+rr_age(struct runqueue *rq)
+{
+  struct proc *p;
+
+  while((p = rq->rr.head) && ticks - p->runnable_since > AGING_CYCLE)
+    promote(p);
+}
+
+struct schedclass rr_class = {
+  .name = "round robin",
+  .queue = ROUND_ROBIN,
+  .quantum = TIME_QUANTUM,
+  .enqueue = rr_enqueue,
+  .dequeue = rr_dequeue,
+  .pick_next = rr_pick_next,
+  .age = rr_age,
+};
+
+#endif
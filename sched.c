@@ -0,0 +1,646 @@
+// Per-CPU run queues and the core of the scheduler.
+//
+// Every RUNNABLE process sits on exactly one CPU's run queue,
+// queued in the scheduling class for its queue (p->queue_num).
+// The policies themselves live in the class files (edf.c,
+// lottery.c, roundrobin.c, mlfq.c, cfs.c, hrrn.c); this file
+// only knows the classes' priority order.  Each run queue keeps
+// a bitmap of the classes that have runnable processes, so a
+// pick goes straight to the highest non-empty class.  A CPU
+// picks from its own run queue first and only when that is
+// empty steals work from the busiest other CPU.
+//
+// Aging is lazy: each process records when it became runnable,
+// and every AGING_INTERVAL ticks the classes with an age
+// operation promote the ones that have waited longer than
+// AGING_CYCLE ticks to LOTTERY.
+//
+// The run queues are protected by ptable.lock: xv6 holds that
+// lock across swtch() and sleep()/wakeup() rely on it, so every
+// state change already happens with it held.  rq->nrunnable may
+// be read without the lock as a hint, which lets an idle CPU
+// see that there is nothing to do without touching ptable.lock.
+
+#include "types.h"
+#include "defs.h"
+#include "param.h"
+#include "memlayout.h"
+#include "mmu.h"
+#include "x86.h"
+#include "proc.h"
+#include "sched.h"
+#include "traps.h"
+
+struct runqueue runqueues[NCPU];
+
+// Scheduling classes, highest priority first.
+static struct schedclass *const classes[] = {
+#if SCHED_HAS(EDF)
+  &edf_class,
+#endif
+#if SCHED_HAS(LOTTERY)
+  &lottery_class,
+#endif
+#if SCHED_HAS(ROUND_ROBIN)
+  &rr_class,
+#endif
+#if SCHED_HAS(MLFQ)
+  &mlfq_class,
+#endif
+#if SCHED_HAS(CFS)
+  &cfs_class,
+#endif
+#if SCHED_HAS(HRRN)
+  &hrrn_class,
+#endif
+};
+
+// NCLASS is a constant, so in a single-class kernel the
+// compiler drops the class lookups, the active bitmap and
+// aging, leaving one direct path to the class.
+#define NCLASS (sizeof(classes)/sizeof(classes[0]))
+
+// Class implementing each queue number.
+static struct schedclass *queueclass[NQUEUE+1];
+
+// Every process that has been queued, by slot, for the load
+// balancer to search.
+static struct proc *slotproc[NPROC];
+
+#define CLASS(p) (NCLASS == 1 ? classes[0] : queueclass[(p)->queue_num])
+
+void
+schedinit(void)
+{
+  int i;
+
+  for(i = 0; i < NCLASS; i++){
+    classes[i]->prio = i;
+    queueclass[classes[i]->queue] = classes[i];
+  }
+}
+
+// Return the class implementing queue, or 0 if there is none.
+struct schedclass*
+sched_class(int queue)
+{
+  if(queue < 1 || queue > NQUEUE)
+    return 0;
+  return queueclass[queue];
+}
+
+void
+proclist_remove(struct proclist *l, struct proc *p)
+{
+  if(p->rq_prev)
+    p->rq_prev->rq_next = p->rq_next;
+  else
+    l->head = p->rq_next;
+  if(p->rq_next)
+    p->rq_next->rq_prev = p->rq_prev;
+  else
+    l->tail = p->rq_prev;
+  p->rq_next = p->rq_prev = 0;
+}
+
+// Insert p into l after q, or at the head if q is 0.
+void
+proclist_insert(struct proclist *l, struct proc *q, struct proc *p)
+{
+  p->rq_prev = q;
+  p->rq_next = q ? q->rq_next : l->head;
+  if(p->rq_next)
+    p->rq_next->rq_prev = p;
+  else
+    l->tail = p;
+  if(q)
+    q->rq_next = p;
+  else
+    l->head = p;
+}
+
+void
+proclist_append(struct proclist *l, struct proc *p)
+{
+  proclist_insert(l, l->tail, p);
+}
+
+// Return the first process in l that can run on cpu, or 0.
+struct proc*
+proclist_first(struct proclist *l, int cpu)
+{
+  struct proc *p;
+
+  for(p = l->head; p && !can_run(p, cpu); p = p->rq_next)
+    ;
+  return p;
+}
+
+// May p run on cpu?  Every process on a CPU's run queue may
+// run there, so this only matters when stealing.
+int
+can_run(struct proc *p, int cpu)
+{
+  return (p->affinity >> cpu) & 1;
+}
+
+// Return the CPU with the fewest runnable processes among
+// those p may run on.
+static int
+least_loaded_cpu(struct proc *p)
+{
+  int i, best;
+
+  best = -1;
+  for(i = 0; i < ncpu; i++)
+    if(can_run(p, i) && (best < 0 || runqueues[i].nrunnable < runqueues[best].nrunnable))
+      best = i;
+  return best;
+}
+
+// Load a process adds to its run queue: its tickets.
+static uint
+loadweight(struct proc *p)
+{
+  return p->ticket ? p->ticket : 1;
+}
+
+// Count p in or out of rq's lock-free hint of how many
+// queued processes each CPU may run (see have_runnable).
+// Throttled EDF processes are left out until they are released.
+void
+count_canrun(struct runqueue *rq, struct proc *p, int d)
+{
+  int i;
+
+  if(p->rt_throttled)
+    return;
+  for(i = 0; i < ncpu; i++)
+    if(can_run(p, i))
+      rq->ncanrun[i] += d;
+}
+
+// Add p to the run queue of p->cpu.
+static void
+queue(struct proc *p)
+{
+  struct schedclass *cl = CLASS(p);
+  struct runqueue *rq = &runqueues[p->cpu];
+
+  slotproc[p->slot] = p;
+  cl->enqueue(rq, p);
+  if(rq->count[cl->queue]++ == 0 && NCLASS > 1)
+    rq->active |= 1 << cl->prio;
+  rq->nrunnable++;
+  count_canrun(rq, p, 1);
+  rq->load += loadweight(p);
+}
+
+// Put the runnable process p on a run queue: the queue of the
+// CPU that last ran it, or the least loaded one it may run on
+// if it has not run yet or may not run there any more.  The
+// ptable lock must be held.
+void
+enqueue_proc(struct proc *p)
+{
+  if(sched_class(p->queue_num) == 0)
+    panic("enqueue_proc queue");
+  if(p->cpu < 0 || !can_run(p, p->cpu))
+    p->cpu = least_loaded_cpu(p);
+  p->runnable_since = ticks;
+  queue(p);
+}
+
+// Put p, which dequeue_proc() just took off its run queue so
+// the caller could change its tickets or affinity, back on one.
+// Unlike enqueue_proc(), this keeps runnable_since, so the
+// process doesn't lose the time it has waited towards aging.
+// The ptable lock must be held.
+void
+requeue_proc(struct proc *p)
+{
+  if(!can_run(p, p->cpu))
+    p->cpu = least_loaded_cpu(p);
+  queue(p);
+}
+
+// Take the runnable process p off its run queue.
+// The ptable lock must be held.
+void
+dequeue_proc(struct proc *p)
+{
+  struct schedclass *cl;
+  struct runqueue *rq;
+
+  cl = CLASS(p);
+  rq = &runqueues[p->cpu];
+  count_canrun(rq, p, -1);
+  cl->dequeue(rq, p);
+  if(--rq->count[cl->queue] == 0 && NCLASS > 1)
+    rq->active &= ~(1 << cl->prio);
+  rq->nrunnable--;
+  rq->load -= loadweight(p);
+}
+
+// Move the queued process p to cpu's run queue.  It keeps its
+// runnable_since, so waiting there still counts towards aging.
+static void
+migrate(struct proc *p, int cpu)
+{
+  dequeue_proc(p);
+  p->cpu = cpu;
+  queue(p);
+}
+
+// Move p to queue, requeueing it if it is runnable.
+// The ptable lock must be held.
+void
+change_queue(struct proc *p, int queue)
+{
+  int runnable = p->state == RUNNABLE;
+
+  if(runnable)
+    dequeue_proc(p);
+  if(queue != p->queue_num){
+    sched_exit(p);
+    p->queue_num = queue;
+    if(queue == MLFQ){
+      // Start at the top, as new processes do.
+      p->mlfq_level = 0;
+      p->mlfq_left = 0;
+    }
+    if(queue == CFS)
+      p->vcpu = -1;  // Start at min_vruntime; the old one is stale.
+  }
+  if(runnable)
+    enqueue_proc(p);
+}
+
+// p is leaving its class, for another or because it is exiting.
+// The ptable lock must be held.
+void
+sched_exit(struct proc *p)
+{
+  struct schedclass *cl = CLASS(p);
+
+  if(cl->leave)
+    cl->leave(p);
+}
+
+// Move the runnable process p to LOTTERY, the highest
+// time-sharing queue.  Called by the classes' age operations.
+void
+promote(struct proc *p)
+{
+  change_queue(p, LOTTERY);
+}
+
+// Let every class that ages its processes do so.
+static void
+age(struct runqueue *rq)
+{
+  int i;
+
+  rq->aging_stamp = ticks;
+  for(i = 0; i < NCLASS; i++)
+    if(classes[i]->age && (rq->active & (1 << i)))
+      classes[i]->age(rq);
+}
+
+// Choose the next process from rq, from the highest non-empty
+// class that has one ready, and take it off the run queue.
+static struct proc*
+runqueue_pick(struct runqueue *rq, int cpu)
+{
+  struct proc *p;
+  uint active;
+  int i;
+
+  if(NCLASS == 1){
+    if(rq->nrunnable == 0)
+      return NOTHING;
+    if((p = classes[0]->pick_next(rq, cpu)) != NOTHING)
+      dequeue_proc(p);
+    return p;
+  }
+
+  if(ticks - rq->aging_stamp >= AGING_INTERVAL)
+    age(rq);
+
+  for(active = rq->active; active; active &= ~(1 << i)){
+    i = __builtin_ctz(active);
+    if((p = classes[i]->pick_next(rq, cpu)) != NOTHING){
+      dequeue_proc(p);
+      return p;
+    }
+  }
+  return NOTHING;
+}
+
+// Choose the next process for CPU c to run and take it off its
+// run queue.  If c has nothing queued, steal from the CPU with
+// the most runnable processes that has one c may run, trying
+// the busiest first.  The ptable lock must be held.
+struct proc*
+pick_next_proc(struct cpu *c)
+{
+  struct runqueue *victim;
+  struct proc *p;
+  uint tried;
+  int i, me;
+
+  me = c - cpus;
+  if((p = runqueue_pick(&runqueues[me], me)) != NOTHING)
+    return p;
+
+  tried = 1 << me;
+  for(;;){
+    victim = 0;
+    for(i = 0; i < ncpu; i++){
+      if((tried & (1 << i)) || runqueues[i].nrunnable == 0)
+        continue;
+      if(victim == 0 || runqueues[i].nrunnable > victim->nrunnable)
+        victim = &runqueues[i];
+    }
+    if(victim == 0)
+      return NOTHING;
+    if((p = runqueue_pick(victim, me)) != NOTHING)
+      break;
+    tried |= 1 << (victim - runqueues);
+  }
+  p->cpu = me;
+  runqueues[me].steals++;
+  return p;
+}
+
+// Is it time for cpu to balance its run queue, and is there
+// anything to balance?  balance() only pulls from a CPU with at
+// least two more runnable processes, so when no CPU has that
+// many, idle and balanced CPUs skip ptable.lock altogether.
+// Reads the counters without the lock; a stale answer only
+// shifts a pass.  Only cpu itself touches its balance_stamp.
+int
+balance_due(int cpu)
+{
+  struct runqueue *rq = &runqueues[cpu];
+  int i;
+
+  if(ncpu < 2 || ticks - rq->balance_stamp < BALANCE_INTERVAL)
+    return 0;
+  rq->balance_stamp = ticks;
+  for(i = 0; i < ncpu; i++)
+    if(i != cpu && runqueues[i].nrunnable >= rq->nrunnable + 2)
+      return 1;
+  return 0;
+}
+
+// Of the processes on rq that cpu may run and that weigh at
+// most max, return the one that has been off a CPU longest,
+// and so is least likely to have a warm cache, or 0.
+static struct proc*
+coldest(struct runqueue *rq, int cpu, uint max)
+{
+  struct proc *p, *best;
+  int i;
+
+  best = 0;
+  for(i = 0; i < NPROC; i++){
+    p = slotproc[i];
+    if(p == 0 || p->state != RUNNABLE || &runqueues[p->cpu] != rq)
+      continue;
+    if(!can_run(p, cpu) || loadweight(p) > max)
+      continue;
+    if(best == 0 || (int)(p->lastrun - best->lastrun) < 0)
+      best = p;
+  }
+  return best;
+}
+
+// Even out cpu's run queue with the busiest other one by
+// pulling processes over until the weighted loads are within
+// half the difference, as long as the busiest keeps at least
+// as many runnable processes.  The ptable lock must be held.
+void
+balance(int cpu)
+{
+  struct runqueue *rq, *busiest;
+  struct proc *p;
+  uint imbalance;
+  int i;
+
+  rq = &runqueues[cpu];
+  rq->balance_stamp = ticks;
+  busiest = 0;
+  for(i = 0; i < ncpu; i++){
+    if(i == cpu)
+      continue;
+    if(busiest == 0 || runqueues[i].load > busiest->load)
+      busiest = &runqueues[i];
+  }
+  if(busiest == 0 || busiest->load <= rq->load)
+    return;
+  imbalance = (busiest->load - rq->load) / 2;
+  while(busiest->nrunnable >= rq->nrunnable + 2 &&
+        (p = coldest(busiest, cpu, imbalance)) != 0){
+    migrate(p, cpu);
+    imbalance -= loadweight(p);
+    rq->balanced++;
+  }
+}
+
+// Restrict p to the CPUs in mask, ignoring CPUs that don't
+// exist.  If p is queued on a CPU it may no longer run on, move
+// it.  The ptable lock must be held.
+int
+set_cpu_mask(struct proc *p, uint mask)
+{
+  mask &= (1 << ncpu) - 1;
+  if(mask == 0)
+    return -1;
+  if(p->state != RUNNABLE){
+    p->affinity = mask;
+    return 0;
+  }
+  // Requeue p even if it stays put, so that rq->ncanrun
+  // follows the new mask.
+  dequeue_proc(p);
+  p->affinity = mask;
+  requeue_proc(p);
+  return 0;
+}
+
+// Halt CPU c until the next interrupt if no run queue has work
+// for it.  The check runs with interrupts off, so an interrupt
+// that queues work can't arrive between it and the hlt.
+void
+idle(struct cpu *c)
+{
+  struct runqueue *rq = &runqueues[c - cpus];
+  uint t0;
+
+  cli();
+  // Announce the halt before the last check; kick() queues
+  // work before it looks, so one of them sees the other.
+  xchg(&rq->halted, 1);
+  if(!have_runnable(c - cpus)){
+    t0 = rdtsc();
+    sti_hlt();
+    rq->idle_cycles += rdtsc() - t0;
+  }
+  rq->halted = 0;
+  sti();
+}
+
+// p was just queued.  Send a reschedule IPI to its CPU if that
+// is halted, or else to a halted CPU that may run p and will
+// steal it, rather than leave p waiting for a timer tick.
+// The ptable lock must be held.
+void
+kick(struct proc *p)
+{
+#ifndef NOWAKEIPI
+  int i, me;
+
+  me = cpuid();
+  if(p->cpu == me && mycpu()->proc == 0)
+    return;  // This CPU will look at its run queue next.
+  __sync_synchronize();
+  if(p->cpu != me && runqueues[p->cpu].halted){
+    lapicipi(cpus[p->cpu].apicid, T_IRQ0 + IRQ_RESCHED);
+    return;
+  }
+  for(i = 0; i < ncpu; i++){
+    if(i != me && runqueues[i].halted && can_run(p, i)){
+      lapicipi(cpus[i].apicid, T_IRQ0 + IRQ_RESCHED);
+      return;
+    }
+  }
+#endif
+}
+
+// Bucket of the wake-up latency histogram for a wait of
+// cycles: bucket b counts waits below 2^(WAKELAT_SHIFT+b+1).
+static int
+latbucket(uint cycles)
+{
+  int b;
+
+  for(b = 0; b < NWAKELAT-1 && cycles >> (WAKELAT_SHIFT+b+1); b++)
+    ;
+  return b;
+}
+
+// Give p, about to be dispatched on p->cpu, a fresh time slice,
+// and count it if it last ran elsewhere.
+void
+start_slice(struct proc *p)
+{
+  struct schedclass *cl = CLASS(p);
+
+  if(p->lastcpu >= 0 && p->lastcpu != p->cpu)
+    p->migrations++;
+  p->lastcpu = p->cpu;
+  p->lastrun = ticks;
+  if(p->waketsc){
+    runqueues[p->cpu].wakelat[latbucket(rdtsc() - p->waketsc)]++;
+    p->waketsc = 0;
+  }
+  // Compensation tickets (lottery.c) last until p runs again,
+  // however often it is requeued meanwhile.
+  p->comp_tickets = 0;
+
+  if(cl->dispatch)
+    cl->dispatch(p);
+  else
+    p->slice = cl->quantum;
+}
+
+// p is blocking before its time slice ran out.
+void
+sched_yield(struct proc *p)
+{
+  struct schedclass *cl = CLASS(p);
+
+  if(cl->yield)
+    cl->yield(p);
+}
+
+// Called on each timer tick while p is running.
+// Returns 1 if p has used up its time slice, or must make way
+// for a real-time process (see edf_preempt).
+int
+slice_tick(struct proc *p)
+{
+  struct schedclass *cl = CLASS(p);
+
+  if(cl->tick && cl->tick(p))
+    return 1;
+  if(--p->slice <= 0)
+    return 1;
+  return edf_preempt(p);
+}
+
+// Set the time slice of queue to n timer ticks.
+// It takes effect at each process's next dispatch.
+int
+set_queue_quantum(int queue, int n)
+{
+  struct schedclass *cl;
+
+  if((cl = sched_class(queue)) == 0 || n < 1)
+    return -1;
+  cl->quantum = n;
+  return 0;
+}
+
+// Set the mode of queue's class.  The ptable lock must be held.
+int
+sched_setmode(int queue, int mode)
+{
+  struct schedclass *cl;
+
+  if((cl = sched_class(queue)) == 0 || cl->setmode == 0)
+    return -1;
+  return cl->setmode(mode);
+}
+
+// Is a process that cpu may run queued on any CPU?  Processes
+// pinned elsewhere don't count: cpu could only pick nothing
+// and spin on ptable.lock.  Nor do throttled EDF processes
+// until their release is due; only a tick can make it due, and
+// the tick wakes cpu from hlt to look again.  Reads the run
+// queue counters without the lock, so the answer is only a hint.
+int
+have_runnable(int cpu)
+{
+  struct runqueue *rq = &runqueues[cpu];
+  int i;
+
+  if(rq->edf_throttled.head && (int)(ticks - rq->edf_release) >= 0)
+    return 1;
+  for(i = 0; i < ncpu; i++)
+    if(runqueues[i].ncanrun[cpu] > 0)
+      return 1;
+  return 0;
+}
+
+// Copy up to n CPUs' statistics into st.
+// Returns the number of CPUs.
+int
+getschedstat(struct cpustat *st, int n)
+{
+  struct runqueue *rq;
+  int i;
+
+  for(i = 0; i < n && i < ncpu; i++){
+    rq = &runqueues[i];
+    st[i].picks = rq->picks;
+    st[i].pick_cycles = rq->pick_cycles;
+    st[i].steals = rq->steals;
+    st[i].idle_ticks = rq->idle_ticks;
+    st[i].idle_cycles = rq->idle_cycles;
+    st[i].balanced = rq->balanced;
+    memmove(st[i].wakelat, rq->wakelat, sizeof(st[i].wakelat));
+  }
+  return ncpu;
+}
@@ -0,0 +1,42 @@
+// Scheduling queue numbers (see set_proc_queue).  These are not
+// in priority order; classes[] in sched.c gives that.
+#define LOTTERY      1
+#define ROUND_ROBIN  2
+#define HRRN         3
+#define CFS          4
+#define EDF          5   // Real-time, ahead of all the others (set_proc_rt)
+#define MLFQ         6
+
+// Modes of the LOTTERY queue (set_queue_mode).
+#define MODE_LOTTERY 0   // Random draws weighted by tickets
+#define MODE_STRIDE  1   // Deterministic stride scheduling by tickets
+
+// One entry of a sched_setparams() call: put pid in queue
+// with ticket tickets, leaving either as it is if SCHED_KEEP.
+// The kernel sets status to 0, or -1 if the entry is invalid.
+#define SCHED_KEEP   (-1)
+
+struct sched_param {
+  int pid;
+  int queue;
+  int ticket;
+  int status;
+};
+
+// Wake-up latency histogram: bucket 0 counts waits of under
+// 2^(WAKELAT_SHIFT+1) TSC cycles, bucket b > 0 waits of
+// 2^(WAKELAT_SHIFT+b) to 2^(WAKELAT_SHIFT+b+1) cycles, and the
+// last bucket everything longer.
+#define WAKELAT_SHIFT 10
+
+// Per-CPU scheduler statistics, as returned by getschedstat().
+// Cycle counts are TSC cycles and wrap, so take differences.
+struct cpustat {
+  uint picks;        // Scheduling decisions made
+  uint pick_cycles;  // Cycles spent making them
+  uint steals;       // Processes taken from other CPUs
+  uint idle_ticks;   // Timer ticks that found the CPU idle
+  uint idle_cycles;  // Cycles spent halted
+  uint balanced;     // Processes pulled over by the load balancer
+  uint wakelat[NWAKELAT];  // Wake-up to dispatch latencies
+};
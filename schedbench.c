@@ -0,0 +1,494 @@
+// Scheduler benchmarks.
+//
+//   schedbench cswitch [pairs] [rounds]
+//   schedbench pick [nproc] [ticks]
+//   schedbench mixed [ticks]
+//   schedbench affinity [jobs] [kb] [rounds]
+//   schedbench wakelat [rounds]
+//   schedbench sleepers [nproc] [ticks]
+//   schedbench forks [batch] [rounds]
+//   schedbench setparams [nproc] [rounds]
+//   schedbench stat
+//
+// Run the same benchmark under different CPU counts
+// (make qemu CPUS=1, CPUS=2, ...) to compare them.  make
+// schedbench runs cswitch and pick under every SCHEDPOLICY.
+
+#include "types.h"
+#include "stat.h"
+#include "user.h"
+#include "param.h"
+#include "sched.h"
+
+int stdout = 1;
+
+// Sum the per-CPU scheduler statistics into st.
+void
+schedstat(struct cpustat *st)
+{
+  struct cpustat cs[NCPU];
+  int i, j, n;
+
+  memset(st, 0, sizeof(*st));
+  n = getschedstat(cs, NCPU);
+  for(i = 0; i < n && i < NCPU; i++){
+    st->picks += cs[i].picks;
+    st->pick_cycles += cs[i].pick_cycles;
+    st->steals += cs[i].steals;
+    st->idle_ticks += cs[i].idle_ticks;
+    st->idle_cycles += cs[i].idle_cycles;
+    st->balanced += cs[i].balanced;
+    for(j = 0; j < NWAKELAT; j++)
+      st->wakelat[j] += cs[i].wakelat[j];
+  }
+}
+
+// Fork n processes that spin until killed.
+// Returns how many were started; pids go in pids[].
+int
+spinners(int *pids, int n)
+{
+  int i;
+  volatile int x = 0;
+
+  for(i = 0; i < n; i++){
+    if((pids[i] = fork()) < 0)
+      break;
+    if(pids[i] == 0)
+      for(;;)
+        x++;
+  }
+  return i;
+}
+
+void
+reap(int *pids, int n)
+{
+  int i;
+
+  for(i = 0; i < n; i++)
+    kill(pids[i]);
+  for(i = 0; i < n; i++)
+    wait();
+}
+
+// Ping-pong a byte between the two ends of a pair of pipes.
+// Every round trip costs two context switches.
+void
+pingpong(int rfd, int wfd, int rounds, int first)
+{
+  char c = 0;
+  int i;
+
+  for(i = 0; i < rounds; i++){
+    if(first && write(wfd, &c, 1) != 1)
+      break;
+    if(read(rfd, &c, 1) != 1)
+      break;
+    if(!first && write(wfd, &c, 1) != 1)
+      break;
+  }
+}
+
+// Context-switch throughput: pairs of processes bouncing a
+// byte back and forth, all pairs running at once.
+void
+cswitch(int pairs, int rounds)
+{
+  int i, t0, t1, a[2], b[2];
+
+  printf(stdout, "cswitch: %d pairs, %d rounds\n", pairs, rounds);
+  t0 = uptime();
+  for(i = 0; i < pairs; i++){
+    if(pipe(a) < 0 || pipe(b) < 0){
+      printf(stdout, "cswitch: pipe failed\n");
+      exit();
+    }
+    if(fork() == 0){
+      pingpong(a[0], b[1], rounds, 1);
+      exit();
+    }
+    if(fork() == 0){
+      pingpong(b[0], a[1], rounds, 0);
+      exit();
+    }
+    close(a[0]);
+    close(a[1]);
+    close(b[0]);
+    close(b[1]);
+  }
+  for(i = 0; i < 2*pairs; i++)
+    wait();
+  t1 = uptime();
+
+  printf(stdout, "cswitch: %d switches in %d ticks", 2*pairs*rounds, t1-t0);
+  if(t1 > t0)
+    printf(stdout, ", %d per tick", 2*pairs*rounds/(t1-t0));
+  printf(stdout, "\n");
+}
+
+// Scheduling decision latency with many runnable processes,
+// all in the queue new processes start in (HRRN, unless the
+// kernel was built with a single SCHEDPOLICY).
+void
+pick(int n, int duration)
+{
+  int pids[NPROC];
+  struct cpustat st0, st1;
+  uint picks;
+
+  if(n > NPROC)
+    n = NPROC;
+  n = spinners(pids, n);
+  printf(stdout, "pick: %d runnable processes, %d ticks\n", n, duration);
+  schedstat(&st0);
+  sleep(duration);
+  schedstat(&st1);
+  reap(pids, n);
+
+  picks = st1.picks - st0.picks;
+  printf(stdout, "pick: %d decisions", picks);
+  if(picks > 0)
+    printf(stdout, ", %d cycles each", (st1.pick_cycles - st0.pick_cycles) / picks);
+  printf(stdout, "\n");
+}
+
+// Spin for about n thousand loop iterations.
+void
+burn(int n)
+{
+  volatile int x = 0;
+  int i;
+
+  for(i = 0; i < 1000*n; i++)
+    x++;
+}
+
+// A CPU hog and an I/O-bound process with equal tickets in
+// LOTTERY.  The I/O process runs a short burst and then blocks
+// for a tick; compensation tickets should let it get the CPU
+// back quickly each time it wakes, instead of waiting out
+// lotteries that the hog wins half the time.  Run with CPUS=1.
+void
+mixed(int duration)
+{
+  int i, pid, p[2], end, n, who, bursts[2];
+
+  if(pipe(p) < 0){
+    printf(stdout, "mixed: pipe failed\n");
+    exit();
+  }
+  end = uptime() + duration;
+  for(who = 0; who < 2; who++){
+    if((pid = fork()) == 0){
+      for(n = 0; uptime() < end; n++){
+        burn(1);
+        if(who == 1)
+          sleep(1);
+      }
+      write(p[1], &who, sizeof(who));
+      write(p[1], &n, sizeof(n));
+      exit();
+    }
+    set_proc_queue(pid, LOTTERY);
+    set_proc_ticket(pid, 10);
+  }
+  for(i = 0; i < 2; i++){
+    read(p[0], &who, sizeof(who));
+    read(p[0], &bursts[who], sizeof(bursts[who]));
+    wait();
+  }
+  close(p[0]);
+  close(p[1]);
+  printf(stdout, "mixed: I/O process ran %d bursts in %d ticks (at most %d)\n",
+         bursts[1], duration, duration);
+  printf(stdout, "mixed: CPU hog ran %d bursts\n", bursts[0]);
+}
+
+// Run one CPU-bound job: rounds passes over a private kb-KB
+// working set, one write per cache line.  Reports its
+// migration count on fd.
+void
+job(int fd, int kb, int rounds)
+{
+  char *buf;
+  int i, r, n;
+
+  if((buf = malloc(kb * 1024)) == 0){
+    printf(stdout, "affinity: out of memory\n");
+    exit();
+  }
+  for(r = 0; r < rounds; r++)
+    for(i = 0; i < kb * 1024; i += 64)
+      buf[i]++;
+  n = get_migrations(getpid());
+  write(fd, &n, sizeof(n));
+  exit();
+}
+
+// Run jobs CPU-bound jobs at once, either free to run anywhere
+// or pinned round-robin to one CPU each, and report the elapsed
+// ticks and how often the jobs moved between CPUs.  A job that
+// stays put keeps its working set in that CPU's cache.
+void
+runjobs(int jobs, int kb, int rounds, int pinned)
+{
+  int i, pid, t0, n, migrations, ncpu, p[2];
+  struct cpustat cs[NCPU];
+
+  ncpu = getschedstat(cs, NCPU);
+  if(pipe(p) < 0){
+    printf(stdout, "affinity: pipe failed\n");
+    exit();
+  }
+  t0 = uptime();
+  for(i = 0; i < jobs; i++){
+    if((pid = fork()) == 0)
+      job(p[1], kb, rounds);
+    if(pid > 0 && pinned)
+      set_affinity(pid, 1 << (i % ncpu));
+  }
+  migrations = 0;
+  for(i = 0; i < jobs; i++){
+    if(read(p[0], &n, sizeof(n)) == sizeof(n))
+      migrations += n;
+    wait();
+  }
+  close(p[0]);
+  close(p[1]);
+  printf(stdout, "affinity: %s: %d ticks, %d migrations\n",
+         pinned ? "pinned" : "unpinned", uptime() - t0, migrations);
+}
+
+// Pinned vs. unpinned CPU-bound jobs.  xv6 can't read the
+// cache-miss counters, so compare the elapsed times.
+void
+affinity(int jobs, int kb, int rounds)
+{
+  printf(stdout, "affinity: %d jobs, %d KB each, %d rounds\n", jobs, kb, rounds);
+  runjobs(jobs, kb, rounds, 0);
+  runjobs(jobs, kb, rounds, 1);
+}
+
+// Wake-up to dispatch latency: two processes pinned to
+// different CPUs ping-pong a byte, so each wakeup targets a
+// CPU that has gone idle.  Compare a kernel built with make
+// WAKEIPI=0, where that CPU only notices at its next tick.
+void
+wakelat(int rounds)
+{
+  struct cpustat st0, st1;
+  int i, a[2], b[2];
+  uint n, total;
+
+  if(getschedstat(&st0, 1) < 2 || set_affinity(getpid(), 2) < 0){
+    printf(stdout, "wakelat: needs 2 CPUs\n");
+    exit();
+  }
+  if(pipe(a) < 0 || pipe(b) < 0){
+    printf(stdout, "wakelat: pipe failed\n");
+    exit();
+  }
+  printf(stdout, "wakelat: %d rounds\n", rounds);
+  schedstat(&st0);
+  if(fork() == 0){
+    set_affinity(getpid(), 1);
+    pingpong(a[0], b[1], rounds, 1);
+    exit();
+  }
+  pingpong(b[0], a[1], rounds, 0);
+  wait();
+  schedstat(&st1);
+  close(a[0]);
+  close(a[1]);
+  close(b[0]);
+  close(b[1]);
+
+  total = 0;
+  for(i = 0; i < NWAKELAT; i++)
+    total += st1.wakelat[i] - st0.wakelat[i];
+  printf(stdout, "wakelat: %d wakeups\n", total);
+  printf(stdout, "cycles  wakeups\n");
+  for(i = 0; i < NWAKELAT; i++){
+    if((n = st1.wakelat[i] - st0.wakelat[i]) == 0)
+      continue;
+    if(i == NWAKELAT-1)
+      printf(stdout, ">= %d  %d\n", 1 << (WAKELAT_SHIFT+i), n);
+    else
+      printf(stdout, "< %d  %d\n", 1 << (WAKELAT_SHIFT+i+1), n);
+  }
+}
+
+// Many processes in long sleep() calls.  They should cost the
+// scheduler nothing until they are due; the kernel used to wake
+// every one of them on every tick to recheck its deadline.
+void
+sleepers(int n, int duration)
+{
+  struct cpustat st0, st1;
+  int i, t0, pid;
+  uint picks;
+
+  if(n > NPROC - 4)
+    n = NPROC - 4;
+  printf(stdout, "sleepers: %d processes sleeping %d ticks\n", n, duration);
+  t0 = uptime();
+  for(i = 0; i < n; i++){
+    if((pid = fork()) < 0)
+      break;
+    if(pid == 0){
+      sleep(duration - (uptime() - t0));
+      exit();
+    }
+  }
+  n = i;
+  // Measure the middle of the sleep, away from the forks and exits.
+  sleep(duration / 4);
+  schedstat(&st0);
+  t0 = uptime();
+  sleep(duration / 2);
+  schedstat(&st1);
+  picks = st1.picks - st0.picks;
+  printf(stdout, "sleepers: %d scheduling decisions in %d ticks\n",
+         picks, uptime() - t0);
+  for(i = 0; i < n; i++)
+    wait();
+}
+
+// Fork/exit/wait throughput: rounds of forking batch children
+// that exit at once, then waiting for all of them.
+void
+forks(int batch, int rounds)
+{
+  int i, r, n, pid, t0, t1;
+
+  if(batch > NPROC - 4)
+    batch = NPROC - 4;
+  printf(stdout, "forks: %d rounds of %d children\n", rounds, batch);
+  n = 0;
+  t0 = uptime();
+  for(r = 0; r < rounds; r++){
+    for(i = 0; i < batch; i++){
+      if((pid = fork()) < 0)
+        break;
+      if(pid == 0)
+        exit();
+    }
+    for(; i > 0; i--, n++)
+      wait();
+  }
+  t1 = uptime();
+  printf(stdout, "forks: %d fork/exit/waits in %d ticks", n, t1-t0);
+  if(t1 > t0)
+    printf(stdout, ", %d per tick", n/(t1-t0));
+  printf(stdout, "\n");
+}
+
+// Retune the queue and tickets of nproc processes, rounds
+// times: first with two syscalls per process, then with one
+// sched_setparams() call for all of them.
+void
+setparams(int n, int rounds)
+{
+  int i, r, t0, t1, pids[NPROC];
+  struct sched_param sp[NPROC];
+
+  if(n > NPROC - 4)
+    n = NPROC - 4;
+  for(i = 0; i < n; i++){
+    if((pids[i] = fork()) < 0)
+      break;
+    if(pids[i] == 0){
+      sleep(100000);
+      exit();
+    }
+  }
+  n = i;
+  printf(stdout, "setparams: %d processes, %d rounds\n", n, rounds);
+
+  t0 = uptime();
+  for(r = 0; r < rounds; r++){
+    for(i = 0; i < n; i++){
+      set_proc_queue(pids[i], r % 2 ? LOTTERY : ROUND_ROBIN);
+      set_proc_ticket(pids[i], 10 + r % 7);
+    }
+  }
+  t1 = uptime();
+  printf(stdout, "setparams: one process per call: %d ticks\n", t1 - t0);
+
+  t0 = uptime();
+  for(r = 0; r < rounds; r++){
+    for(i = 0; i < n; i++){
+      sp[i].pid = pids[i];
+      sp[i].queue = r % 2 ? LOTTERY : ROUND_ROBIN;
+      sp[i].ticket = 10 + r % 7;
+    }
+    if(sched_setparams(sp, n) < 0){
+      printf(stdout, "setparams: sched_setparams failed\n");
+      break;
+    }
+  }
+  t1 = uptime();
+  printf(stdout, "setparams: batched: %d ticks\n", t1 - t0);
+
+  reap(pids, n);
+}
+
+// Per-CPU scheduler counters since boot.
+void
+showstat(void)
+{
+  struct cpustat cs[NCPU];
+  int i, n;
+
+  n = getschedstat(cs, NCPU);
+  printf(stdout, "cpu  picks  steals  balanced  idle ticks\n");
+  for(i = 0; i < n && i < NCPU; i++)
+    printf(stdout, "%d    %d  %d  %d  %d\n", i, cs[i].picks, cs[i].steals,
+           cs[i].balanced, cs[i].idle_ticks);
+}
+
+void
+usage(void)
+{
+  printf(2, "usage: schedbench cswitch [pairs] [rounds]\n");
+  printf(2, "       schedbench pick [nproc] [ticks]\n");
+  printf(2, "       schedbench mixed [ticks]\n");
+  printf(2, "       schedbench affinity [jobs] [kb] [rounds]\n");
+  printf(2, "       schedbench wakelat [rounds]\n");
+  printf(2, "       schedbench sleepers [nproc] [ticks]\n");
+  printf(2, "       schedbench forks [batch] [rounds]\n");
+  printf(2, "       schedbench setparams [nproc] [rounds]\n");
+  printf(2, "       schedbench stat\n");
+  exit();
+}
+
+int
+main(int argc, char *argv[])
+{
+  if(argc < 2)
+    usage();
+
+  if(strcmp(argv[1], "cswitch") == 0)
+    cswitch(argc > 2 ? atoi(argv[2]) : 4, argc > 3 ? atoi(argv[3]) : 2000);
+  else if(strcmp(argv[1], "pick") == 0)
+    pick(argc > 2 ? atoi(argv[2]) : 64, argc > 3 ? atoi(argv[3]) : 500);
+  else if(strcmp(argv[1], "mixed") == 0)
+    mixed(argc > 2 ? atoi(argv[2]) : 1000);
+  else if(strcmp(argv[1], "affinity") == 0)
+    affinity(argc > 2 ? atoi(argv[2]) : 4, argc > 3 ? atoi(argv[3]) : 256,
+             argc > 4 ? atoi(argv[4]) : 2000);
+  else if(strcmp(argv[1], "wakelat") == 0)
+    wakelat(argc > 2 ? atoi(argv[2]) : 1000);
+  else if(strcmp(argv[1], "sleepers") == 0)
+    sleepers(argc > 2 ? atoi(argv[2]) : 60, argc > 3 ? atoi(argv[3]) : 400);
+  else if(strcmp(argv[1], "forks") == 0)
+    forks(argc > 2 ? atoi(argv[2]) : 32, argc > 3 ? atoi(argv[3]) : 100);
+  else if(strcmp(argv[1], "setparams") == 0)
+    setparams(argc > 2 ? atoi(argv[2]) : 32, argc > 3 ? atoi(argv[3]) : 1000);
+  else if(strcmp(argv[1], "stat") == 0)
+    showstat();
+  else
+    usage();
+  exit();
+}
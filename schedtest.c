@@ -0,0 +1,467 @@
+// Scheduler tests.  Everything runs pinned to CPU 0 (see
+// main), so they work with any number of CPUs.
+
+#include "param.h"
+#include "types.h"
+#include "stat.h"
+#include "user.h"
+#include "sched.h"
+
+int stdout = 1;
+
+// Fork one child per entry of tickets[], all in queue, and let
+// them count loop iterations for duration ticks.  The counts
+// come back in counts[].  Returns 0 on success.
+int
+race(int queue, int *tickets, int n, int duration, int *counts)
+{
+  int i, j, pid, end, go[2], done[2];
+  volatile int x;
+
+  if(pipe(go) < 0 || pipe(done) < 0){
+    printf(stdout, "pipe failed\n");
+    return -1;
+  }
+  for(i = 0; i < n; i++){
+    pid = fork();
+    if(pid < 0){
+      printf(stdout, "fork failed\n");
+      return -1;
+    }
+    if(pid == 0){
+      close(go[1]);
+      close(done[0]);
+      if(read(go[0], &end, sizeof(end)) != sizeof(end))
+        exit();
+      x = 0;
+      while(uptime() < end){
+        for(j = 0; j < 1000; j++)
+          x++;
+        counts[i]++;
+      }
+      write(done[1], &i, sizeof(i));
+      write(done[1], &counts[i], sizeof(counts[i]));
+      exit();
+    }
+    set_proc_queue(pid, queue);
+    set_proc_ticket(pid, tickets[i]);
+  }
+  close(go[0]);
+  close(done[1]);
+
+  end = uptime() + duration;
+  for(i = 0; i < n; i++)
+    write(go[1], &end, sizeof(end));
+  for(i = 0; i < n; i++){
+    if(read(done[0], &j, sizeof(j)) != sizeof(j) || j < 0 || j >= n ||
+       read(done[0], &counts[j], sizeof(counts[j])) != sizeof(counts[j])){
+      printf(stdout, "lost a result\n");
+      return -1;
+    }
+  }
+  for(i = 0; i < n; i++)
+    wait();
+  close(go[1]);
+  close(done[0]);
+  return 0;
+}
+
+// Check that each child's share of the work is within tolerance
+// percentage points of its share of the tickets.
+int
+checkshare(char *name, int *tickets, int *counts, int n, int tolerance)
+{
+  int i, total, work, want, got, ok;
+
+  total = work = 0;
+  for(i = 0; i < n; i++){
+    total += tickets[i];
+    work += counts[i];
+  }
+  if(work < 100){
+    printf(stdout, "%s: too little work done\n", name);
+    return 0;
+  }
+  ok = 1;
+  for(i = 0; i < n; i++){
+    want = 100 * tickets[i] / total;
+    got = counts[i] / (work / 100);
+    printf(stdout, "%s: %d tickets, want %d%%, got %d%%\n", name, tickets[i], want, got);
+    if(got < want - tolerance || got > want + tolerance)
+      ok = 0;
+  }
+  return ok;
+}
+
+// CPU shares of LOTTERY processes should follow their tickets.
+void
+lotteryshare(void)
+{
+  int tickets[] = { 16, 24, 40 };
+  int counts[3] = { 0, 0, 0 };
+
+  printf(stdout, "lottery share test\n");
+  sched_seed(1);
+  if(race(LOTTERY, tickets, 3, 1000, counts) < 0 ||
+     !checkshare("lottery", tickets, counts, 3, 8)){
+    printf(stdout, "lottery share test failed\n");
+    exit();
+  }
+  printf(stdout, "lottery share test ok\n");
+}
+
+// In MODE_STRIDE the same tickets give exact shares, even
+// over a run much shorter than the lottery test's.
+void
+strideshare(void)
+{
+  int tickets[] = { 16, 24, 40 };
+  int counts[3] = { 0, 0, 0 };
+  int ok;
+
+  printf(stdout, "stride share test\n");
+  if(set_queue_mode(LOTTERY, MODE_STRIDE) < 0){
+    printf(stdout, "stride share test failed: set_queue_mode\n");
+    exit();
+  }
+  ok = race(LOTTERY, tickets, 3, 200, counts) == 0 &&
+       checkshare("stride", tickets, counts, 3, 2);
+  set_queue_mode(LOTTERY, MODE_LOTTERY);
+  if(!ok){
+    printf(stdout, "stride share test failed\n");
+    exit();
+  }
+  printf(stdout, "stride share test ok\n");
+}
+
+// A pinned process never migrates.
+void
+affinitytest(void)
+{
+  int pid, end;
+
+  printf(stdout, "affinity test\n");
+  end = uptime() + 50;
+  if((pid = fork()) == 0){
+    while(uptime() < end)
+      ;
+    exit();
+  }
+  sleep(25);
+  if(get_affinity(pid) != 1 || get_migrations(pid) != 0){
+    printf(stdout, "affinity test failed: mask %x, %d migrations\n",
+           get_affinity(pid), get_migrations(pid));
+    exit();
+  }
+  wait();
+  printf(stdout, "affinity test ok\n");
+}
+
+// CFS shares follow the weights (tickets) deterministically,
+// so the tolerance is much tighter than the lottery's.
+void
+cfsshare(void)
+{
+  int tickets[] = { 10, 20, 30 };
+  int counts[3] = { 0, 0, 0 };
+
+  printf(stdout, "cfs share test\n");
+  if(race(CFS, tickets, 3, 500, counts) < 0 ||
+     !checkshare("cfs", tickets, counts, 3, 3)){
+    printf(stdout, "cfs share test failed\n");
+    exit();
+  }
+  printf(stdout, "cfs share test ok\n");
+}
+
+// A CFS process that sleeps while a weight-1 hog runs on for
+// longer than it takes the hog's virtual runtime to move 2^31
+// ahead must still get the CPU back promptly, not look far
+// ahead of the hog and starve.  Takes about 2200 ticks.
+void
+cfssleeper(void)
+{
+  int i, j, pid, start, wake, end, tag, n[2], share, p[2];
+  volatile int x;
+
+  printf(stdout, "cfs sleeper test\n");
+  if(pipe(p) < 0){
+    printf(stdout, "pipe failed\n");
+    exit();
+  }
+  start = uptime() + 10;
+  wake = start + 2150;
+  end = wake + 50;
+  // Both count their loops from wake to end.  The sleeper runs
+  // in CFS for a moment first so it has a vruntime to go stale.
+  for(i = 0; i < 2; i++){
+    if((pid = fork()) == 0){
+      sleep(start - uptime());
+      if(i == 1){
+        while(uptime() < start + 5)
+          ;
+        sleep(wake - uptime());
+      }
+      x = 0;
+      for(n[i] = 0; uptime() < end; ){
+        for(j = 0; j < 1000; j++)
+          x++;
+        if(uptime() >= wake)
+          n[i]++;
+      }
+      write(p[1], &i, sizeof(i));
+      write(p[1], &n[i], sizeof(n[i]));
+      exit();
+    }
+    set_proc_queue(pid, CFS);
+    set_proc_ticket(pid, i == 0 ? 1 : 10);
+  }
+  sleep(end + 10 - uptime());
+  for(i = 0; i < 2; i++){
+    if(read(p[0], &tag, sizeof(tag)) != sizeof(tag) || tag < 0 || tag > 1 ||
+       read(p[0], &n[tag], sizeof(n[tag])) != sizeof(n[tag])){
+      printf(stdout, "cfs sleeper test failed: lost a result\n");
+      exit();
+    }
+  }
+  wait();
+  wait();
+  close(p[0]);
+  close(p[1]);
+  if(n[0] + n[1] == 0){
+    printf(stdout, "cfs sleeper test failed: no work done\n");
+    exit();
+  }
+  // Weights 10:1, so the sleeper should get about 90%.
+  share = 100 * n[1] / (n[0] + n[1]);
+  printf(stdout, "cfs sleeper: weight 10 vs 1 after waking, got %d%%\n", share);
+  if(share < 50){
+    printf(stdout, "cfs sleeper test failed\n");
+    exit();
+  }
+  printf(stdout, "cfs sleeper test ok\n");
+}
+
+// Spin until uptime() reaches end, then report tag and the
+// loop count on fd.
+void
+spin(int fd, int tag, int end)
+{
+  int j, n;
+  volatile int x;
+
+  x = 0;
+  for(n = 0; uptime() < end; n++)
+    for(j = 0; j < 1000; j++)
+      x++;
+  write(fd, &tag, sizeof(tag));
+  write(fd, &n, sizeof(n));
+  exit();
+}
+
+// EDF admission stops at 100% utilization, and an EDF process
+// runs ahead of everything else but only for its budget.
+void
+edftest(void)
+{
+  int i, pid, rt, p[2], end, tag, n[2], share;
+
+  printf(stdout, "edf test\n");
+  if((pid = fork()) == 0){
+    sleep(1000);
+    exit();
+  }
+  if(set_proc_rt(pid, 10, 6, 10) < 0 ||
+     set_proc_rt(getpid(), 10, 5, 10) == 0 ||
+     set_proc_rt(getpid(), 10, 4, 20) == 0 ||
+     set_proc_rt(getpid(), 10, 0, 10) == 0 ||
+     set_proc_rt(pid, 10, 2, 10) < 0 ||
+     set_proc_rt(getpid(), 10, 5, 10) < 0){
+    printf(stdout, "edf test failed: admission\n");
+    exit();
+  }
+  kill(pid);
+  wait();
+  set_proc_queue(getpid(), LOTTERY);
+
+  if(pipe(p) < 0){
+    printf(stdout, "pipe failed\n");
+    exit();
+  }
+  end = uptime() + 500;
+  if((rt = fork()) == 0)
+    spin(p[1], 0, end);
+  set_proc_rt(rt, 10, 3, 10);
+  if((pid = fork()) == 0)
+    spin(p[1], 1, end);
+  set_proc_queue(pid, LOTTERY);
+  // Don't compete with them.
+  sleep(520);
+  n[0] = n[1] = 0;
+  while(wait() != -1)
+    ;
+  for(i = 0; i < 2; i++){
+    if(read(p[0], &tag, sizeof(tag)) != sizeof(tag) || tag < 0 || tag > 1 ||
+       read(p[0], &n[tag], sizeof(n[tag])) != sizeof(n[tag])){
+      printf(stdout, "edf test failed: lost a result\n");
+      exit();
+    }
+  }
+  close(p[0]);
+  close(p[1]);
+  // The RT child (tag 0) gets its budget and no more.
+  if(n[0] + n[1] == 0){
+    printf(stdout, "edf test failed: no work done\n");
+    exit();
+  }
+  share = 100 * n[0] / (n[0] + n[1]);
+  printf(stdout, "edf: budget 30%%, got %d%%\n", share);
+  if(share < 25 || share > 35){
+    printf(stdout, "edf budget test failed\n");
+    exit();
+  }
+  printf(stdout, "edf test ok\n");
+}
+
+// An interactive process in MLFQ should get the CPU back soon
+// after every wakeup, even with CPU hogs in MLFQ beside it: the
+// hogs burn whole slices and sink, the sleeper stays on top and
+// preempts them at the next tick.  It wakes about once a tick,
+// so it should manage well over 100 wakeups in 300 ticks.
+void
+mlfqtest(void)
+{
+  int i, p[2], q[2], end, n;
+  volatile int x;
+
+  printf(stdout, "mlfq test\n");
+  if(pipe(p) < 0 || pipe(q) < 0){
+    printf(stdout, "pipe failed\n");
+    exit();
+  }
+  // Children inherit MLFQ.
+  set_proc_queue(getpid(), MLFQ);
+  end = uptime() + 300;
+  for(i = 0; i < 3; i++)
+    if(fork() == 0)
+      spin(p[1], i, end);
+  if(fork() == 0){
+    x = 0;
+    for(n = 0; uptime() < end; n++){
+      for(i = 0; i < 1000; i++)
+        x++;
+      sleep(1);
+    }
+    write(q[1], &n, sizeof(n));
+    exit();
+  }
+  set_proc_queue(getpid(), LOTTERY);
+  sleep(320);
+  for(i = 0; i < 4; i++)
+    wait();
+  n = 0;
+  read(q[0], &n, sizeof(n));
+  close(p[0]);
+  close(p[1]);
+  close(q[0]);
+  close(q[1]);
+  printf(stdout, "mlfq: interactive process woke %d times in 300 ticks\n", n);
+  if(n < 100){
+    printf(stdout, "mlfq test failed\n");
+    exit();
+  }
+  printf(stdout, "mlfq test ok\n");
+}
+
+// sched_setparams() applies a batch only if every entry is
+// valid, and flags the ones that aren't.
+void
+setparamstest(void)
+{
+  struct sched_param sp[3];
+  int pid;
+
+  printf(stdout, "setparams test\n");
+  if((pid = fork()) == 0){
+    sleep(1000);
+    exit();
+  }
+  sp[0].pid = pid;
+  sp[0].queue = LOTTERY;
+  sp[0].ticket = 20;
+  sp[1].pid = getpid();
+  sp[1].queue = SCHED_KEEP;
+  sp[1].ticket = 10;
+  sp[2].pid = pid;
+  sp[2].queue = EDF;
+  sp[2].ticket = SCHED_KEEP;
+  if(sched_setparams(sp, 3) == 0 || sp[0].status != 0 ||
+     sp[1].status != 0 || sp[2].status != -1){
+    printf(stdout, "setparams test failed: bad entry not caught\n");
+    exit();
+  }
+  sp[2].queue = ROUND_ROBIN;
+  if(sched_setparams(sp, 3) < 0 || sp[2].status != 0){
+    printf(stdout, "setparams test failed: valid batch rejected\n");
+    exit();
+  }
+  kill(pid);
+  wait();
+  if(sched_setparams(sp, 1) == 0 || sp[0].status != -1){
+    printf(stdout, "setparams test failed: dead pid accepted\n");
+    exit();
+  }
+  printf(stdout, "setparams test ok\n");
+}
+
+// An unpinned child may run on every CPU, and get_affinity()
+// must not mistake its mask for an error.
+void
+unpinnedtest(void)
+{
+  struct cpustat cs[NCPU];
+  int pid, ncpu, mask;
+
+  printf(stdout, "unpinned test\n");
+  ncpu = getschedstat(cs, NCPU);
+  if((pid = fork()) == 0){
+    sleep(1000);
+    exit();
+  }
+  mask = get_affinity(pid);
+  kill(pid);
+  wait();
+  if(mask != (1 << ncpu) - 1){
+    printf(stdout, "unpinned test failed: mask %x with %d CPUs\n", mask, ncpu);
+    exit();
+  }
+  printf(stdout, "unpinned test ok\n");
+}
+
+int
+main(int argc, char *argv[])
+{
+  printf(stdout, "schedtest starting\n");
+  // Before main pins itself, which its children inherit.
+  unpinnedtest();
+  // Shares are only proportional among processes competing for
+  // the same CPU, so keep this process and its children on CPU 0.
+  if(set_affinity(getpid(), 1) < 0 || get_affinity(getpid()) != 1){
+    printf(stdout, "set_affinity failed\n");
+    exit();
+  }
+  if(set_affinity(getpid(), 0) == 0){
+    printf(stdout, "set_affinity accepted an empty mask\n");
+    exit();
+  }
+  affinitytest();
+  lotteryshare();
+  strideshare();
+  cfsshare();
+  cfssleeper();
+  edftest();
+  mlfqtest();
+  setparamstest();
+  printf(stdout, "schedtest done\n");
+  exit();
+}
@@ -106,6 +106,16 @@ extern int sys_uptime(void);
 extern int sys_set_proc_queue(void);
 extern int sys_set_proc_ticket(void);
 extern int sys_print_processes(void);
+extern int sys_getschedstat(void);
+extern int sys_set_queue_quantum(void);
+extern int sys_sched_seed(void);
+extern int sys_set_queue_mode(void);
+extern int sys_set_proc_rt(void);
+extern int sys_set_mlfq_boost(void);
+extern int sys_set_affinity(void);
+extern int sys_get_affinity(void);
+extern int sys_get_migrations(void);
+extern int sys_sched_setparams(void);
 
 static int (*syscalls[])(void) = {
 [SYS_fork]            sys_fork,
@@ -132,6 +142,16 @@ static int (*syscalls[])(void) = {
 [SYS_set_proc_queue]  sys_set_proc_queue,
 [SYS_set_proc_ticket] sys_set_proc_ticket,
 [SYS_print_processes] sys_print_processes,
+[SYS_getschedstat]    sys_getschedstat,
+[SYS_set_queue_quantum] sys_set_queue_quantum,
+[SYS_sched_seed]      sys_sched_seed,
+[SYS_set_queue_mode]  sys_set_queue_mode,
+[SYS_set_proc_rt]     sys_set_proc_rt,
+[SYS_set_mlfq_boost]  sys_set_mlfq_boost,
+[SYS_set_affinity]    sys_set_affinity,
+[SYS_get_affinity]    sys_get_affinity,
+[SYS_get_migrations]  sys_get_migrations,
+[SYS_sched_setparams] sys_sched_setparams,
 };
 
 void
@@ -23,3 +23,13 @@
 #define SYS_set_proc_queue 	22
 #define SYS_set_proc_ticket 23
 #define SYS_print_processes 24
+#define SYS_getschedstat    25
+#define SYS_set_queue_quantum 26
+#define SYS_sched_seed      27
+#define SYS_set_queue_mode  28
+#define SYS_set_proc_rt     29
+#define SYS_set_mlfq_boost  30
+#define SYS_set_affinity    31
+#define SYS_get_affinity    32
+#define SYS_get_migrations  33
+#define SYS_sched_setparams 34
@@ -6,6 +6,8 @@
 #include "memlayout.h"
 #include "mmu.h"
 #include "proc.h"
+#include "sched.h"
+#include "timer.h"
 
 int
 sys_fork(void)
@@ -61,17 +63,23 @@ sys_sleep(void)
 {
   int n;
   uint ticks0;
+  struct timer t;
 
   if(argint(0, &n) < 0)
     return -1;
   acquire(&tickslock);
   ticks0 = ticks;
+  // Sleep on a timer of our own, so that only its expiry (or
+  // kill) wakes us, not every tick.
+  if(n != 0)
+    timer_add(&t, ticks0 + n);
   while(ticks - ticks0 < n){
     if(myproc()->killed){
+      timer_del(&t);
       release(&tickslock);
       return -1;
     }
-    sleep(&ticks, &tickslock);
+    sleep(&t, &tickslock);
   }
   release(&tickslock);
   return 0;
@@ -118,4 +126,125 @@ int
 sys_print_processes(void)
 {
   return print_processes();
-}
\ No newline at end of file
+}
+
+int
+sys_getschedstat(void)
+{
+  struct cpustat *st;
+  int n;
+
+  if(argint(1, &n) < 0 || n < 0)
+    return -1;
+  if(n > ncpu)
+    n = ncpu;
+  if(argptr(0, (void*)&st, n*sizeof(*st)) < 0)
+    return -1;
+  return getschedstat(st, n);
+}
+
+int
+sys_set_queue_quantum(void)
+{
+  int queue;
+  int quantum;
+
+  if(argint(0, &queue) < 0 || argint(1, &quantum) < 0)
+    return -1;
+
+  return set_queue_quantum(queue, quantum);
+}
+
+// Reseed the lottery's random number generators.
+int
+sys_sched_seed(void)
+{
+  int seed;
+
+  if(argint(0, &seed) < 0)
+    return -1;
+  srand(seed);
+  return 0;
+}
+
+// Switch queue between scheduling modes, e.g. LOTTERY
+// between MODE_LOTTERY and MODE_STRIDE.
+int
+sys_set_queue_mode(void)
+{
+  int queue, mode;
+
+  if(argint(0, &queue) < 0 || argint(1, &mode) < 0)
+    return -1;
+  return set_queue_mode(queue, mode);
+}
+
+// Make pid a real-time process with the given period, runtime
+// budget and relative deadline, in ticks.
+int
+sys_set_proc_rt(void)
+{
+  int pid, period, runtime, deadline;
+
+  if(argint(0, &pid) < 0 || argint(1, &period) < 0 ||
+     argint(2, &runtime) < 0 || argint(3, &deadline) < 0)
+    return -1;
+  return set_proc_rt(pid, period, runtime, deadline);
+}
+
+// Set the MLFQ priority boost interval, in ticks.
+int
+sys_set_mlfq_boost(void)
+{
+  int n;
+
+  if(argint(0, &n) < 0)
+    return -1;
+  return set_mlfq_boost(n);
+}
+
+// Restrict pid to the CPUs in a bitmap, bit i for CPU i.
+int
+sys_set_affinity(void)
+{
+  int pid, mask;
+
+  if(argint(0, &pid) < 0 || argint(1, &mask) < 0)
+    return -1;
+  return set_affinity(pid, mask);
+}
+
+int
+sys_get_affinity(void)
+{
+  int pid;
+
+  if(argint(0, &pid) < 0)
+    return -1;
+  return get_affinity(pid);
+}
+
+// How many times pid has moved to another CPU.
+int
+sys_get_migrations(void)
+{
+  int pid;
+
+  if(argint(0, &pid) < 0)
+    return -1;
+  return get_migrations(pid);
+}
+
+// Apply an array of (pid, queue, ticket) updates in one go.
+int
+sys_sched_setparams(void)
+{
+  struct sched_param *sp;
+  int n;
+
+  if(argint(1, &n) < 0 || n < 0 || n > 0x7fffffff / sizeof(*sp))
+    return -1;
+  if(argptr(0, (void*)&sp, n*sizeof(*sp)) < 0)
+    return -1;
+  return sched_setparams(sp, n);
+}
@@ -0,0 +1,116 @@
+// Hierarchical timer wheel, for sleeping until a given tick.
+//
+// Level 0 has a slot for each of the next WHEEL_SIZE ticks;
+// each slot of level l > 0 covers WHEEL_SIZE^l ticks.  A timer
+// goes in the lowest level whose range reaches its expiry, and
+// when level 0 wraps around, the next slot of level 1 is
+// cascaded down into it (and so on up), so each tick only
+// looks at one level-0 slot, all of whose timers are due.
+// Adding and deleting a timer are O(1).
+//
+// Firing a timer wakes up whoever sleeps on it (see sys_sleep),
+// so a sleeper only wakes when its time has come instead of
+// on every tick.  Everything here is protected by tickslock.
+
+#include "types.h"
+#include "defs.h"
+#include "param.h"
+#include "spinlock.h"
+#include "timer.h"
+
+#define WHEEL_BITS 6
+#define WHEEL_SIZE (1 << WHEEL_BITS)
+#define WHEEL_MASK (WHEEL_SIZE - 1)
+#define NLEVEL     4   // Covers 2^24 ticks; later timers cascade again
+
+static struct timer *wheel[NLEVEL][WHEEL_SIZE];
+static uint now;       // Last tick run by timer_tick
+
+static void
+link(struct timer *t)
+{
+  uint delta, expires;
+  struct timer **slot;
+  int l;
+
+  expires = t->expires;
+  delta = expires - now;
+  if(delta >= 1 << (WHEEL_BITS * NLEVEL)){
+    // Too far out: park it in the top level's last slot.
+    delta = (1 << (WHEEL_BITS * NLEVEL)) - 1;
+    expires = now + delta;
+  }
+  for(l = 0; l < NLEVEL-1 && delta >= 1 << (WHEEL_BITS * (l+1)); l++)
+    ;
+  slot = &wheel[l][(expires >> (WHEEL_BITS * l)) & WHEEL_MASK];
+  t->next = *slot;
+  if(t->next)
+    t->next->pprev = &t->next;
+  t->pprev = slot;
+  *slot = t;
+}
+
+static void
+unlink(struct timer *t)
+{
+  *t->pprev = t->next;
+  if(t->next)
+    t->next->pprev = t->pprev;
+  t->pprev = 0;
+}
+
+// Arrange for t to fire when ticks reaches expires, which must
+// be after the current tick.
+void
+timer_add(struct timer *t, uint expires)
+{
+  if(!holding(&tickslock))
+    panic("timer_add");
+  t->expires = expires;
+  link(t);
+}
+
+// Cancel t, if it hasn't fired yet.
+void
+timer_del(struct timer *t)
+{
+  if(!holding(&tickslock))
+    panic("timer_del");
+  if(t->pprev)
+    unlink(t);
+}
+
+// Move the timers in slot idx of level l down to lower levels.
+// Returns idx, which is 0 when level l has wrapped around too.
+static int
+cascade(int l, int idx)
+{
+  struct timer *t, *next;
+
+  t = wheel[l][idx];
+  wheel[l][idx] = 0;
+  for(; t; t = next){
+    next = t->next;
+    link(t);
+  }
+  return idx;
+}
+
+// Fire the timers due at the current tick.
+// Called once per tick, with tickslock held.
+void
+timer_tick(void)
+{
+  struct timer *t;
+  int l, idx;
+
+  now = ticks;
+  idx = now & WHEEL_MASK;
+  for(l = 1; idx == 0 && l < NLEVEL; l++)
+    idx = cascade(l, (now >> (WHEEL_BITS * l)) & WHEEL_MASK);
+
+  while((t = wheel[0][now & WHEEL_MASK]) != 0){
+    unlink(t);
+    wakeup(t);
+  }
+}
@@ -0,0 +1,6 @@
+// A timer in the timer wheel (timer.c).  Protected by tickslock.
+struct timer {
+  uint expires;          // Value of ticks to fire at
+  struct timer *next;    // Next timer in the same wheel slot
+  struct timer **pprev;  // Link that points at this timer, 0 once fired
+};
@@ -51,9 +51,17 @@ trap(struct trapframe *tf)
     if(cpuid() == 0){
       acquire(&tickslock);
       ticks++;
-      wakeup(&ticks);
+      timer_tick();
       release(&tickslock);
     }
+    if(myproc() == 0)
+      runqueues[cpuid()].idle_ticks++;
+    balancetick();
+    lapiceoi();
+    break;
+  case T_IRQ0 + IRQ_RESCHED:
+    // Only sent to wake a halted CPU, which then finds the
+    // new work in its scheduler loop.
     lapiceoi();
     break;
   case T_IRQ0 + IRQ_IDE:
@@ -100,10 +108,10 @@ trap(struct trapframe *tf)
   if(myproc() && myproc()->killed && (tf->cs&3) == DPL_USER)
     exit();
 
-  // Force process to give up CPU on clock tick.
+  // Force process to give up CPU once its time slice is used up.
   // If interrupts were on while locks held, would need to check nlock.
   if(myproc() && myproc()->state == RUNNING &&
-     tf->trapno == T_IRQ0+IRQ_TIMER)
+     tf->trapno == T_IRQ0+IRQ_TIMER && slice_tick(myproc()))
     yield();
 
   // Check if the process has been killed since we yielded
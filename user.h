@@ -1,6 +1,8 @@
 #include "types.h"
 
 struct stat;
+struct cpustat;
+struct sched_param;
 struct rtcdate;
 
 // system calls
@@ -28,6 +30,16 @@ int uptime(void);
 int set_proc_queue(int, int);
 int set_proc_ticket(int, int);
 int print_processes(void);
+int getschedstat(struct cpustat*, int);
+int set_queue_quantum(int, int);
+int sched_seed(int);
+int set_queue_mode(int, int);
+int set_proc_rt(int, int, int, int);
+int set_mlfq_boost(int);
+int set_affinity(int, uint);
+int get_affinity(int);
+int get_migrations(int);
+int sched_setparams(struct sched_param*, int);
 
 // ulib.c
 int stat(const char*, struct stat*);